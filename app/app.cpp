@@ -6,6 +6,7 @@
 #include <Shlwapi.h>
 #include <winreg.h>
 #include <cstdlib>
+#include <cwchar>
 
 // Registry key path for auto-start programs
 const wchar_t* AUTO_START_KEY = L"Software\\Microsoft\\Windows\\CurrentVersion\\Run";
@@ -40,6 +41,12 @@ bool Application::initialize() {
         }
     }
 
+    // Map the user-recorded gesture templates; the file is created when the first gesture is recorded
+    std::wstring libraryPath = std::wstring(exePath) + L"\\gestures.bin";
+    m_gestureLibrary.load(libraryPath);
+    m_gestureAnalyzer.setTemplateLibrary(&m_gestureLibrary);
+    applyGestureSettings();
+
     // Configure auto-start based on settings
     if (m_settings.isAutoStartEnabled() != isAutoStartConfigured()) {
         setupAutoStart(m_settings.isAutoStartEnabled());
@@ -60,67 +67,112 @@ bool Application::initialize() {
         m_trayIcon->addMenuItem(L"Setting", []() {
             // todo: open SettingUI dialog
         });
+        m_trayIcon->addMenuItem(L"Record Left Gesture", [this]() {
+            recordGesture(GestureAnalyzer::Direction::Left);
+        });
+        m_trayIcon->addMenuItem(L"Record Right Gesture", [this]() {
+            recordGesture(GestureAnalyzer::Direction::Right);
+        });
+        m_trayIcon->addMenuItem(L"Overlay Memory", [this]() {
+            size_t bytes = m_overlay.surfaceBytes();
+            wchar_t message[64];
+            if (bytes > 0) {
+                swprintf_s(message, L"Overlay surface: %.1f MB", bytes / (1024.0 * 1024.0));
+            } else {
+                swprintf_s(message, L"Overlay surface released");
+            }
+            m_trayIcon->showNotification(L"Virtual Desktop Switcher", message);
+        });
         m_trayIcon->addMenuItem(L"Exit", []() {
             PostQuitMessage(0);
         });
     }
 
-    MouseHook& mouseHook = MouseHook::getInstance();
-    if (!mouseHook.initialize()) {
-        return false;
-    }
-
     // Since lambda in member functions can't capture 'this' directly in initialization,
-    // we create a local copy of the callback to use with the mouse hook
-    auto callback = [this](int code, WPARAM wParam, LPARAM lParam) {
-        UNREFERENCED_PARAMETER(code);
-        if (m_settings.getTriggerButton() == MouseButton::None) {
-            trace("Trigger button is set to None, ignoring mouse events.");
-            return;
-        }
-
-        // Handle mouse events based on configured trigger button
-        int triggerButton = static_cast<int>(m_settings.getTriggerButton());
-        if (wParam == WM_XBUTTONDOWN || wParam == WM_LBUTTONDOWN || wParam == WM_RBUTTONDOWN) {
-            auto* mouseData = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-            bool isTriggerButton = (wParam == WM_XBUTTONDOWN) ? (HIWORD(mouseData->mouseData) == (triggerButton - 2))
-                                                              : ((int)(wParam - WM_LBUTTONDOWN + 1) == triggerButton);
-            if (!isTriggerButton) {
-                return;
+    // we create a local copy of the callback to use with the mouse hook.
+    // It runs on the mouse hook worker thread, which owns the gesture analyzer and draws the overlay.
+    // The hook only delivers presses and releases of the trigger button and the moves in between.
+    auto callback = [this](const MouseEvent& event) {
+        UINT message = event.message;
+        if (message == WM_XBUTTONDOWN || message == WM_LBUTTONDOWN || message == WM_RBUTTONDOWN) {
+            // Apply an edited config file between gestures, on the thread that owns the analyzer and overlay
+            if (m_settingsChanged.exchange(false)) {
+                applyGestureSettings();
+                m_overlay.setSettings(m_settings);
             }
-            // Start gesture analysis
+
+            // Start gesture analysis, with the early-commit limits fixed for the whole gesture
+            const SettingsSnapshot& settings = m_settings.snapshot();
+            m_earlyCommit = settings.earlyCommit;
+            m_earlyCommitConfidence = settings.earlyCommitConfidence;
+            m_earlyCommitDistance = settings.earlyCommitDistance;
+            m_gestureCommitted = false;
             m_gestureAnalyzer.clearPositions();
-            m_gestureAnalyzer.addPosition(mouseData->pt.x, mouseData->pt.y);
+            m_gestureAnalyzer.addPosition(event.x, event.y, event.time);
             m_overlay.show();
-            m_overlay.updatePosition(mouseData->pt.x, mouseData->pt.y);
-        } else if (wParam == WM_XBUTTONUP || wParam == WM_LBUTTONUP || wParam == WM_RBUTTONUP) {
-            auto* mouseData = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
-            bool isTriggerButton = (wParam == WM_XBUTTONUP) ? (HIWORD(mouseData->mouseData) == (triggerButton - 2))
-                                                            : ((int)(wParam - WM_LBUTTONUP + 1) == triggerButton);
-            if (!isTriggerButton) {
+            m_overlay.updatePosition(event.x, event.y);
+        } else if (message == WM_XBUTTONUP || message == WM_LBUTTONUP || message == WM_RBUTTONUP) {
+            auto recordingDirection = m_recordingDirection.exchange(GestureAnalyzer::Direction::None);
+            if (recordingDirection != GestureAnalyzer::Direction::None) {
+                // Store the stroke as a template instead of switching desktops
+                GestureAnalyzer::GestureTemplate gestureTemplate;
+                bool recorded = m_gestureAnalyzer.createTemplate(recordingDirection, gestureTemplate) &&
+                                m_gestureLibrary.add(gestureTemplate);
+                if (recorded) {
+                    useConfiguredRecognizer();
+                }
+                if (m_trayIcon) {
+                    m_trayIcon->showNotification(
+                            L"Virtual Desktop Switcher", recorded ? L"Gesture recorded" : L"Failed to record gesture");
+                }
+                m_gestureAnalyzer.clearPositions();
+                m_overlay.hide();
                 return;
             }
-            // Analyze gesture and switch virtual desktop
-            auto direction = m_gestureAnalyzer.analyzeGesture();
-            trace("Gesture direction: %d", static_cast<int>(direction));
-            if (direction == GestureAnalyzer::Direction::Left) {
-                m_desktopManager.switchDesktop(false);
-            } else if (direction == GestureAnalyzer::Direction::Right) {
-                m_desktopManager.switchDesktop(true);
+
+            // Analyze gesture and switch virtual desktop, unless the gesture was committed early
+            if (!m_gestureCommitted) {
+                auto direction = m_gestureAnalyzer.analyzeGesture();
+                trace("Gesture direction: %d", static_cast<int>(direction));
+                switchForGesture(direction);
             }
+            m_gestureCommitted = false;
             m_gestureAnalyzer.clearPositions();
             m_overlay.hide();
-        } else if (wParam == WM_MOUSEMOVE) {
+        } else if (message == WM_MOUSEMOVE) {
             // Record mouse movement only when side button is pressed
-            auto* mouseData = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
             if (m_gestureAnalyzer.isGestureInProgress()) {
-                m_gestureAnalyzer.addPosition(mouseData->pt.x, mouseData->pt.y);
-                m_overlay.updatePosition(mouseData->pt.x, mouseData->pt.y);
+                m_gestureAnalyzer.addPosition(event.x, event.y, event.time);
+                m_overlay.updatePosition(event.x, event.y);
+
+                // Early commit: switch as soon as the running decision is firm, at most once per gesture
+                if (!m_gestureCommitted && m_recordingDirection == GestureAnalyzer::Direction::None && m_earlyCommit) {
+                    auto direction = m_gestureAnalyzer.analyzeEarly(m_earlyCommitConfidence, m_earlyCommitDistance);
+                    if (switchForGesture(direction)) {
+                        trace("Gesture direction committed early: %d", static_cast<int>(direction));
+                        m_gestureCommitted = true;
+                    }
+                }
             }
         }
     };
 
-    mouseHook.addCallback(callback);
+    // The hook starts delivering events as soon as it is installed, so register the callback first
+    MouseHook& mouseHook = MouseHook::getInstance();
+    configureTrigger();
+    mouseHook.addCallback(callback, MouseHook::TriggerButton | MouseHook::ArmedMove);
+    if (!mouseHook.initialize()) {
+        return false;
+    }
+
+    // Pick up edits of the config file while running
+    m_configWatcher.start(m_settings, configPath, [this]() {
+        configureTrigger();
+        if (m_settings.isAutoStartEnabled() != isAutoStartConfigured()) {
+            setupAutoStart(m_settings.isAutoStartEnabled());
+        }
+        m_settingsChanged.store(true);
+    });
 
     return true;
 }
@@ -131,7 +183,68 @@ void Application::run() {
         TranslateMessage(&msg);
         DispatchMessage(&msg);
     }
-    m_settings.save(L"config.json");
+    MouseHook::getInstance().shutdown();
+    // Writes unsaved settings to the file they were loaded from
+    m_configWatcher.stop();
+}
+
+void Application::recordGesture(GestureAnalyzer::Direction direction) {
+    // The next stroke drawn with the trigger button becomes a template for this direction
+    m_recordingDirection = direction;
+    if (m_trayIcon) {
+        m_trayIcon->showNotification(L"Virtual Desktop Switcher", L"Draw the gesture with the trigger button to record it");
+    }
+}
+
+bool Application::switchForGesture(GestureAnalyzer::Direction direction) {
+    if (direction == GestureAnalyzer::Direction::Left) {
+        m_desktopManager.switchDesktop(false);
+    } else if (direction == GestureAnalyzer::Direction::Right) {
+        m_desktopManager.switchDesktop(true);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void Application::configureTrigger() {
+    switch (m_settings.getTriggerButton()) {
+        case MouseButton::Left:
+            MouseHook::getInstance().setTrigger(WM_LBUTTONDOWN);
+            break;
+        case MouseButton::Right:
+            MouseHook::getInstance().setTrigger(WM_RBUTTONDOWN);
+            break;
+        case MouseButton::X1:
+            MouseHook::getInstance().setTrigger(WM_XBUTTONDOWN, XBUTTON1);
+            break;
+        case MouseButton::X2:
+            MouseHook::getInstance().setTrigger(WM_XBUTTONDOWN, XBUTTON2);
+            break;
+        default:
+            trace("Trigger button is set to None, ignoring mouse events.");
+            MouseHook::getInstance().setTrigger(0);
+            break;
+    }
+}
+
+void Application::applyGestureSettings() {
+    useConfiguredRecognizer();
+    m_gestureAnalyzer.setStrokeLimits(
+            static_cast<size_t>(m_settings.getStrokeCapacity()), m_settings.getStrokeDecimationRadius());
+    m_gestureAnalyzer.setSensitivity(m_settings.getGestureSensitivity());
+}
+
+void Application::useConfiguredRecognizer() {
+    std::string recognizer = m_settings.getRecognizer();
+    // The simple recognizer ignores templates, so recorded gestures switch to the template recognizer
+    if (recognizer == "simple" && m_gestureLibrary.size() > 0) {
+        recognizer = "unistroke";
+    }
+    if (!m_gestureAnalyzer.setRecognizer(recognizer)) {
+        trace("Unknown gesture recognizer %s, using simple", recognizer.c_str());
+        m_gestureAnalyzer.setRecognizer("simple");
+    }
 }
 
 bool Application::setupAutoStart(bool enable) {
@@ -1,10 +1,14 @@
 #pragma once
 
+#include "ConfigWatcher.h"
 #include "DesktopManager.h"
 #include "GestureAnalyzer.h"
+#include "GestureLibrary.h"
 #include "OverlayUI.h"
 #include "Settings.h"
 #include "TrayIcon.h"
+#include <atomic>
+#include <cstdint>
 
 namespace VirtualDesktop {
 
@@ -17,12 +21,27 @@ public:
 private:
     bool setupAutoStart(bool enable);
     bool isAutoStartConfigured() const;
+    void recordGesture(GestureAnalyzer::Direction direction);
+    void configureTrigger();
+    void applyGestureSettings();
+    void useConfiguredRecognizer();
+    bool switchForGesture(GestureAnalyzer::Direction direction);
 
     HINSTANCE m_hInstance;
     std::unique_ptr<TrayIcon> m_trayIcon;
     Settings m_settings;
+    ConfigWatcher m_configWatcher;
+    std::atomic<bool> m_settingsChanged{false};  // The config file was reloaded and not yet applied to gestures
     DesktopManager m_desktopManager;
+    GestureLibrary m_gestureLibrary;
     GestureAnalyzer m_gestureAnalyzer;
+    // Set from the tray menu on the UI thread, consumed by the mouse hook worker thread
+    std::atomic<GestureAnalyzer::Direction> m_recordingDirection{GestureAnalyzer::Direction::None};
+    bool m_gestureCommitted = false;  // The current gesture already switched desktops before the button was released
+    // Early-commit limits of the current gesture, read from the settings at its trigger press
+    bool m_earlyCommit = false;
+    double m_earlyCommitConfidence = 0.0;
+    int32_t m_earlyCommitDistance = 0;
     OverlayUI m_overlay;
 };
 
@@ -0,0 +1,378 @@
+// Measures what the mouse hook thread pays per event and how fast events reach the worker, and writes it as JSON
+#include "MouseEventQueue.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace VirtualDesktop {
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct Options {
+    std::string outPath = "hook_bench.json";
+    std::vector<std::string> sections = {"queue", "dispatch"};
+    int events = 50000;
+    int intervalNs = 20000;
+    int batches = 2000;
+};
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+struct Summary {
+    double p50;
+    double p99;
+    double max;
+};
+
+Summary summarize(std::vector<double>& samples) {
+    if (samples.empty()) {
+        return {0.0, 0.0, 0.0};
+    }
+    std::sort(samples.begin(), samples.end());
+    return {percentile(samples, 0.5), percentile(samples, 0.99), samples.back()};
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+bool contains(const std::vector<std::string>& list, const std::string& item) {
+    return std::find(list.begin(), list.end(), item) != list.end();
+}
+
+double nanosecondsBetween(Clock::time_point start, Clock::time_point end) {
+    return std::chrono::duration<double, std::nano>(end - start).count();
+}
+
+// The queue the hook used to need: a mutex around a deque, as a baseline for MouseEventQueue
+class MutexQueue {
+public:
+    bool pushEvent(const MouseEventQueue::Item& item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_items.push_back(item);
+        return true;
+    }
+
+    bool tryPop(MouseEventQueue::Item& item) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_items.empty()) {
+            return false;
+        }
+        item = m_items.front();
+        m_items.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    std::deque<MouseEventQueue::Item> m_items;
+};
+
+// The hook thread pushes moves at a steady rate while the worker polls; both sides time every event.
+// Each move carries its number in x, which indexes its send time.
+template <typename Queue>
+nlohmann::json runQueue(const char* name, const Options& options) {
+    constexpr uint32_t MOVE = 4;
+    const size_t count = static_cast<size_t>(options.events);
+    const auto interval = std::chrono::nanoseconds(options.intervalNs);
+    Queue queue;
+    std::vector<Clock::time_point> sent(count);
+    std::vector<double> pushCosts;
+    pushCosts.reserve(count);
+    std::atomic<bool> done{false};
+    size_t dropped = 0;
+
+    std::thread hook([&] {
+        Clock::time_point next = Clock::now();
+        for (size_t i = 0; i < count; ++i) {
+            while (Clock::now() < next) {
+            }
+            next += interval;
+            MouseEventQueue::Item item = {{0x0200, static_cast<int32_t>(i), 0, 0, 0}, MOVE};
+            sent[i] = Clock::now();
+            bool queued = queue.pushEvent(item);
+            pushCosts.push_back(nanosecondsBetween(sent[i], Clock::now()));
+            dropped += queued ? 0 : 1;
+        }
+        done.store(true);
+    });
+
+    std::vector<double> latencies;
+    latencies.reserve(count);
+    MouseEventQueue::Item item;
+    for (;;) {
+        const bool finished = done.load();
+        if (queue.tryPop(item)) {
+            latencies.push_back(nanosecondsBetween(sent[static_cast<size_t>(item.event.x)], Clock::now()) / 1000.0);
+        } else if (finished) {
+            break;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    hook.join();
+
+    Summary push = summarize(pushCosts);
+    Summary latency = summarize(latencies);
+    printf("queue    %-6s  push p50 %7.0f ns  p99 %7.0f ns  max %9.0f ns  "
+           "delivery p50 %8.1f us  p99 %8.1f us  dropped %zu\n",
+           name,
+           push.p50,
+           push.p99,
+           push.max,
+           latency.p50,
+           latency.p99,
+           dropped);
+    return {
+            {"section", "queue"},
+            {"queue", name},
+            {"events", count},
+            {"interval_ns", options.intervalNs},
+            {"push_p50_ns", push.p50},
+            {"push_p99_ns", push.p99},
+            {"push_max_ns", push.max},
+            {"delivery_p50_us", latency.p50},
+            {"delivery_p99_us", latency.p99},
+            {"dropped", dropped},
+    };
+}
+
+// Cost for the hook thread of handing over one move, and the time until the worker has it
+nlohmann::json benchQueue(const Options& options) {
+    nlohmann::json results = nlohmann::json::array();
+    results.push_back(runQueue<MouseEventQueue>("spsc", options));
+    results.push_back(runQueue<MutexQueue>("mutex", options));
+    return results;
+}
+
+volatile int32_t g_sink;  // Keeps the work of the replicated callbacks alive
+
+// What the hook thread did for every mouse event before subscription masks: call each registered
+// std::function, whose body looked the trigger button up twice in the JSON settings (copying the "gesture"
+// object, lowercasing and comparing the name) before checking whether a gesture was in progress
+class CallbackDispatch {
+public:
+    explicit CallbackDispatch(bool gestureInProgress) : m_gestureInProgress(gestureInProgress) {
+        m_config = nlohmann::json::parse(R"({
+            "basic": {"auto_start": false, "tray_icon": true},
+            "gesture": {"trigger_button": "X1", "sensitivity": 5, "line_width": 5, "color": "#6495EDAA",
+                        "recognizer": "simple"}
+        })");
+        m_callbacks.push_back([this](const MouseEvent& event) {
+            if (triggerButton() == 0) {
+                return;
+            }
+            const int trigger = triggerButton();
+            if (event.message == WM_MOUSEMOVE && m_gestureInProgress) {
+                // The gesture work that followed now runs on the worker, so only its inputs are kept
+                g_sink = event.x + event.y + trigger;
+            }
+        });
+    }
+
+    void dispatch(const MouseEvent& event) {
+        for (const auto& callback : m_callbacks) {
+            callback(event);
+        }
+    }
+
+private:
+    static constexpr uint32_t WM_MOUSEMOVE = 0x0200;
+
+    int triggerButton() const {
+        std::string button = m_config.value("gesture", nlohmann::json::object()).value("trigger_button", "X1");
+        std::transform(button.begin(), button.end(), button.begin(), [](char c) {
+            return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        });
+        if (button == "x1") {
+            return 4;
+        } else if (button == "x2") {
+            return 5;
+        } else if (button == "left") {
+            return 1;
+        } else if (button == "right") {
+            return 2;
+        }
+        return 0;
+    }
+
+    nlohmann::json m_config;
+    std::vector<std::function<void(const MouseEvent&)>> m_callbacks;
+    bool m_gestureInProgress;
+};
+
+// What MouseHook::hookCallback does for a move now: pick the kind from the armed flag, test it against the
+// union of the subscribed masks, and only then copy the event into the queue for the worker
+class MaskDispatch {
+public:
+    explicit MaskDispatch(bool armed) : m_armed(armed) {
+    }
+
+    void dispatch(const MouseEvent& event) {
+        uint32_t kind = m_armed.load(std::memory_order_relaxed) ? ARMED_MOVE : IDLE_MOVE;
+        if ((m_subscribedMask.load(std::memory_order_relaxed) & kind) != 0) {
+            m_queue.pushEvent({event, kind});
+        }
+    }
+
+    // Empties the queue as the worker would, between timed batches
+    void drain() {
+        MouseEventQueue::Item item;
+        while (m_queue.tryPop(item)) {
+        }
+    }
+
+private:
+    // MouseHook::EventMask bits; the application subscribes to the trigger button and armed moves
+    static constexpr uint32_t TRIGGER_BUTTON = 1u << 0;
+    static constexpr uint32_t ARMED_MOVE = 1u << 2;
+    static constexpr uint32_t IDLE_MOVE = 1u << 3;
+
+    std::atomic<bool> m_armed;
+    std::atomic<uint32_t> m_subscribedMask{TRIGGER_BUTTON | ARMED_MOVE};
+    MouseEventQueue m_queue;
+};
+
+// Cost for the hook thread of one mouse move, with no gesture in progress and while a gesture is drawn.
+// The hook procedure itself needs Windows; this times what it runs per event, in batches of moves.
+nlohmann::json benchDispatch(const Options& options) {
+    constexpr int BATCH = 512;  // Below the queue's capacity minus its trigger headroom
+    std::vector<MouseEvent> moves(BATCH);
+    for (int i = 0; i < BATCH; ++i) {
+        moves[static_cast<size_t>(i)] = {0x0200, 100 + i, 200 + i / 2, 0, static_cast<uint32_t>(i)};
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+    auto time = [&](const char* dispatch, const char* state, auto& dispatcher, auto drain) {
+        std::vector<double> samples;
+        samples.reserve(static_cast<size_t>(options.batches));
+        for (int batch = 0; batch < options.batches; ++batch) {
+            Clock::time_point start = Clock::now();
+            for (const MouseEvent& move : moves) {
+                dispatcher.dispatch(move);
+            }
+            samples.push_back(nanosecondsBetween(start, Clock::now()) / BATCH);
+            drain();
+        }
+        Summary summary = summarize(samples);
+        printf("dispatch %-9s  %-6s  p50 %8.2f ns  p99 %8.2f ns per move\n", dispatch, state, summary.p50, summary.p99);
+        results.push_back({
+                {"section", "dispatch"},
+                {"dispatch", dispatch},
+                {"state", state},
+                {"p50_ns", summary.p50},
+                {"p99_ns", summary.p99},
+        });
+    };
+
+    for (bool active : {false, true}) {
+        const char* state = active ? "active" : "idle";
+        CallbackDispatch callbacks(active);
+        time("callbacks", state, callbacks, [] {
+        });
+        MaskDispatch masks(active);
+        time("masks", state, masks, [&masks] {
+            masks.drain();
+        });
+    }
+    return results;
+}
+
+void printUsage() {
+    printf("Usage: hook_bench [options]\n"
+           "  --out FILE        JSON results file (default hook_bench.json)\n"
+           "  --sections LIST   queue,dispatch\n"
+           "  --events N        Events pushed per case (default 50000)\n"
+           "  --interval NS     Time between pushed events in ns (default 20000)\n"
+           "  --batches N       Timed batches of 512 moves per dispatch case (default 2000)\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--out") {
+            options.outPath = value;
+        } else if (arg == "--sections") {
+            options.sections = splitList(value);
+        } else if (arg == "--events") {
+            options.events = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--interval") {
+            options.intervalNs = std::max(0, std::atoi(value.c_str()));
+        } else if (arg == "--batches") {
+            options.batches = std::max(1, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int runBenchmarks(const Options& options) {
+    nlohmann::json results = nlohmann::json::array();
+    auto append = [&results](const nlohmann::json& section) {
+        results.insert(results.end(), section.begin(), section.end());
+    };
+    if (contains(options.sections, "queue")) {
+        append(benchQueue(options));
+    }
+    if (contains(options.sections, "dispatch")) {
+        append(benchDispatch(options));
+    }
+
+    nlohmann::json document = {
+            {"benchmark", "hook"},
+            {"version", 1},
+            {"results", results},
+    };
+    std::ofstream out(options.outPath);
+    out << document.dump(2) << '\n';
+    if (!out) {
+        fprintf(stderr, "Failed to write %s\n", options.outPath.c_str());
+        return 1;
+    }
+    printf("%zu results written to %s\n", results.size(), options.outPath.c_str());
+    return 0;
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main(int argc, char** argv) {
+    VirtualDesktop::Options options;
+    if (!VirtualDesktop::parseOptions(argc, argv, options)) {
+        VirtualDesktop::printUsage();
+        return 2;
+    }
+    return VirtualDesktop::runBenchmarks(options);
+}
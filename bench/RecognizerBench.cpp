@@ -0,0 +1,859 @@
+// Replays synthetic strokes through the gesture recognizers and writes the cost of every case as JSON
+#define _USE_MATH_DEFINES
+#include "GestureAnalyzer.h"
+#include "GestureKernels.h"
+#include "GestureLibrary.h"
+#include "UnistrokeRecognizer.h"
+#include "nlohmann/json.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace VirtualDesktop {
+namespace {
+
+using Positions = IGestureRecognizer::Positions;
+
+struct Stroke {
+    std::string name;
+    Positions points;
+};
+
+struct Options {
+    std::string outPath = "recognizer_bench.json";
+    std::vector<std::string> sections = {"resample", "matchers", "kernels", "search", "early"};
+    std::vector<int> points = {10, 100, 1000, 10000};
+    int repeats = 200;
+    int corpus = 500;
+    int queries = 100;
+    std::vector<int> templates = {0, 16, 64, 256, 1024};
+};
+
+// Exposes the preprocessing step, so resampling is timed without template matching
+class ResampleProbe : public UnistrokeRecognizer {
+public:
+    using UnistrokeRecognizer::candidate;
+    using UnistrokeRecognizer::prepareCandidate;
+};
+
+// Exposes the recognition thresholds the matchers are calibrated with
+class Thresholds : public UnistrokeRecognizer {
+public:
+    using UnistrokeRecognizer::PROTRACTOR_THRESHOLD;
+    using UnistrokeRecognizer::UNISTROKE_THRESHOLD;
+};
+
+// Exposes the resolutions of the coarse-to-fine cascade, to weigh prefilter searches against full ones
+class Resolutions : public UnistrokeRecognizer {
+public:
+    using UnistrokeRecognizer::NUM_POINTS;
+    using UnistrokeRecognizer::PREFILTER_POINTS;
+};
+
+// Swipe of 600 px to the right with a vertical wobble; long strokes have sub-pixel steps like a fast mouse
+Stroke makeSwipe(size_t count) {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> jitter(-1, 1);
+    Stroke stroke = {"swipe", {}};
+    for (size_t i = 0; i < count; ++i) {
+        double t = count > 1 ? static_cast<double>(i) / static_cast<double>(count - 1) : 0.0;
+        double x = 100.0 + 600.0 * t;
+        double y = 500.0 + 30.0 * std::sin(t * 6.0);
+        stroke.points.push_back({static_cast<int32_t>(x) + jitter(random), static_cast<int32_t>(y) + jitter(random)});
+    }
+    return stroke;
+}
+
+// Random walk of 8 px steps that turns gradually: the path keeps growing with the number of positions
+Stroke makeScribble(size_t count) {
+    std::mt19937 random(2);
+    std::uniform_real_distribution<double> turn(-0.3, 0.3);
+    Stroke stroke = {"scribble", {}};
+    double x = 1000.0;
+    double y = 1000.0;
+    double angle = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        angle += turn(random);
+        x += 8.0 * std::cos(angle);
+        y += 8.0 * std::sin(angle);
+        stroke.points.push_back({static_cast<int32_t>(x), static_cast<int32_t>(y)});
+    }
+    return stroke;
+}
+
+// Labelled synthetic gestures: straight swipes in any direction and shapes that are no swipe at all, drawn
+// 150-600 px large with 1 px jitter and sampled every 4-12 px like a mouse moving at moderate speed
+class GestureCorpus {
+public:
+    explicit GestureCorpus(uint32_t seed) : m_random(seed) {
+    }
+
+    std::vector<Stroke> generate(size_t perShape) {
+        std::vector<Stroke> strokes;
+        for (size_t i = 0; i < perShape; ++i) {
+            strokes.push_back(line());
+            strokes.push_back(wave());
+            strokes.push_back(arc());
+            strokes.push_back(circle());
+            strokes.push_back(corner());
+            strokes.push_back(zigzag());
+            strokes.push_back(outAndBack());
+            strokes.push_back(randomWalk());
+        }
+        return strokes;
+    }
+
+private:
+    double uniform(double low, double high) {
+        return std::uniform_real_distribution<double>(low, high)(m_random);
+    }
+
+    // Samples a polyline given as a function of t in [0, 1] at roughly even spacing along the path
+    template <typename Path>
+    Stroke sample(const char* name, Path path) {
+        constexpr int STEPS = 2000;
+        const double spacing = uniform(4.0, 12.0);
+        const double originX = uniform(500.0, 1500.0);
+        const double originY = uniform(500.0, 1500.0);
+        std::uniform_int_distribution<int> jitter(-1, 1);
+        Stroke stroke = {name, {}};
+        Point previous = path(0.0);
+        double travelled = spacing;
+        for (int i = 0; i <= STEPS; ++i) {
+            Point p = path(static_cast<double>(i) / STEPS);
+            travelled += std::hypot(p.x - previous.x, p.y - previous.y);
+            previous = p;
+            if (travelled >= spacing || i == STEPS) {
+                travelled = 0.0;
+                stroke.points.push_back(
+                        {static_cast<int32_t>(std::lround(originX + p.x)) + jitter(m_random),
+                         static_cast<int32_t>(std::lround(originY + p.y)) + jitter(m_random)});
+            }
+        }
+        return stroke;
+    }
+
+    Stroke line() {
+        const double angle = uniform(0.0, 2.0 * M_PI);
+        const double length = uniform(150.0, 600.0);
+        return sample("line", [&](double t) {
+            return Point(length * t * std::cos(angle), length * t * std::sin(angle));
+        });
+    }
+
+    // Swipe with a sideways wave of up to 40% of its length
+    Stroke wave() {
+        const double angle = uniform(0.0, 2.0 * M_PI);
+        const double length = uniform(150.0, 600.0);
+        const double amplitude = length * uniform(0.02, 0.4);
+        const double periods = uniform(0.5, 3.0);
+        return sample("wave", [&](double t) {
+            double along = length * t;
+            double across = amplitude * std::sin(2.0 * M_PI * periods * t);
+            return Point(
+                    along * std::cos(angle) - across * std::sin(angle),
+                    along * std::sin(angle) + across * std::cos(angle));
+        });
+    }
+
+    Stroke arc() {
+        const double start = uniform(0.0, 2.0 * M_PI);
+        const double sweep = uniform(30.0, 300.0) * M_PI / 180.0 * (uniform(0.0, 1.0) < 0.5 ? -1.0 : 1.0);
+        const double radius = uniform(75.0, 300.0);
+        return sample("arc", [&](double t) {
+            return Point(radius * std::cos(start + sweep * t), radius * std::sin(start + sweep * t));
+        });
+    }
+
+    Stroke circle() {
+        const double start = uniform(0.0, 2.0 * M_PI);
+        const double sweep = uniform(330.0, 420.0) * M_PI / 180.0;
+        const double radius = uniform(75.0, 300.0);
+        return sample("circle", [&](double t) {
+            return Point(radius * std::cos(start + sweep * t), radius * std::sin(start + sweep * t));
+        });
+    }
+
+    // Two legs at a right angle
+    Stroke corner() {
+        const double angle = uniform(0.0, 2.0 * M_PI);
+        const double turn = (uniform(0.0, 1.0) < 0.5 ? -0.5 : 0.5) * M_PI;
+        const double first = uniform(100.0, 400.0);
+        const double second = uniform(100.0, 400.0);
+        return sample("corner", [&](double t) {
+            double d = t * (first + second);
+            Point p(std::min(d, first) * std::cos(angle), std::min(d, first) * std::sin(angle));
+            if (d > first) {
+                p += Point(std::cos(angle + turn), std::sin(angle + turn)) * (d - first);
+            }
+            return p;
+        });
+    }
+
+    // Three to five legs alternating 90-150 degrees left and right
+    Stroke zigzag() {
+        const int legs = static_cast<int>(uniform(3.0, 6.0));
+        const double leg = uniform(80.0, 250.0);
+        const double turn = uniform(90.0, 150.0) * M_PI / 180.0;
+        double angle = uniform(0.0, 2.0 * M_PI);
+        std::vector<Point> corners = {Point()};
+        for (int i = 0; i < legs; ++i) {
+            corners.push_back(corners.back() + Point(std::cos(angle), std::sin(angle)) * leg);
+            angle += (i % 2 == 0) ? turn : -turn;
+        }
+        return sample("zigzag", [&](double t) {
+            double position = std::min(t * legs, legs - 1e-9);
+            size_t index = static_cast<size_t>(position);
+            return corners[index] + (corners[index + 1] - corners[index]) * (position - index);
+        });
+    }
+
+    Stroke outAndBack() {
+        const double angle = uniform(0.0, 2.0 * M_PI);
+        const double length = uniform(150.0, 400.0);
+        const double back = length * uniform(0.5, 1.0);
+        return sample("out_and_back", [&](double t) {
+            double d = t * (length + back);
+            double along = d < length ? d : 2.0 * length - d;
+            return Point(along * std::cos(angle), along * std::sin(angle));
+        });
+    }
+
+    // Smooth random curve through eight waypoints
+    Stroke randomWalk() {
+        std::vector<Point> waypoints = {Point()};
+        double angle = uniform(0.0, 2.0 * M_PI);
+        for (int i = 0; i < 8; ++i) {
+            angle += uniform(-1.5, 1.5);
+            waypoints.push_back(waypoints.back() + Point(std::cos(angle), std::sin(angle)) * uniform(40.0, 120.0));
+        }
+        return sample("random_walk", [&](double t) {
+            double position = std::min(t * 8.0, 8.0 - 1e-9);
+            size_t index = static_cast<size_t>(position);
+            return waypoints[index] + (waypoints[index + 1] - waypoints[index]) * (position - index);
+        });
+    }
+
+    std::mt19937 m_random;
+};
+
+double elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+struct Summary {
+    double p50;
+    double p99;
+    double mean;
+};
+
+Summary summarize(std::vector<double>& samples) {
+    std::sort(samples.begin(), samples.end());
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+    return {percentile(samples, 0.5), percentile(samples, 0.99), total / static_cast<double>(samples.size())};
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<int> parseIntList(const std::string& list) {
+    std::vector<int> values;
+    for (const std::string& item : splitList(list)) {
+        values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+bool contains(const std::vector<std::string>& list, const std::string& item) {
+    return std::find(list.begin(), list.end(), item) != list.end();
+}
+
+// Cost of feeding a stroke position by position and of resampling it on release, with and without streaming
+nlohmann::json benchResample(const Options& options) {
+    nlohmann::json results = nlohmann::json::array();
+    for (int count : options.points) {
+        if (count < 3) {
+            continue;
+        }
+        for (const Stroke& stroke : {makeSwipe(static_cast<size_t>(count)), makeScribble(static_cast<size_t>(count))}) {
+            // Largest distance between the streamed and batch candidates, in normalized units (the stroke spans 250)
+            ResampleProbe batchProbe;
+            ResampleProbe streamProbe;
+            streamProbe.setStreaming(true);
+            for (const auto& position : stroke.points) {
+                streamProbe.addPoint(position.first, position.second);
+            }
+            batchProbe.prepareCandidate(stroke.points);
+            streamProbe.prepareCandidate(stroke.points);
+            double deviation = 0.0;
+            for (size_t i = 0; i < batchProbe.candidate().size(); ++i) {
+                Point difference = batchProbe.candidate()[i] - streamProbe.candidate()[i];
+                deviation = std::max(deviation, std::hypot(difference.x, difference.y));
+            }
+
+            for (bool streaming : {false, true}) {
+                ResampleProbe probe;
+                probe.setStreaming(streaming);
+                std::vector<double> addSamples;
+                std::vector<double> releaseSamples;
+                addSamples.reserve(static_cast<size_t>(options.repeats));
+                releaseSamples.reserve(static_cast<size_t>(options.repeats));
+                for (int repeat = 0; repeat < options.repeats; ++repeat) {
+                    probe.reset();
+                    auto start = std::chrono::steady_clock::now();
+                    for (const auto& position : stroke.points) {
+                        probe.addPoint(position.first, position.second);
+                    }
+                    addSamples.push_back(elapsedMicroseconds(start) * 1000.0 / count);
+                    start = std::chrono::steady_clock::now();
+                    probe.prepareCandidate(stroke.points);
+                    releaseSamples.push_back(elapsedMicroseconds(start));
+                }
+                Summary add = summarize(addSamples);
+                Summary release = summarize(releaseSamples);
+                const char* mode = streaming ? "streaming" : "batch";
+                printf("resample %-9s %-8s %6d pts  add p50 %7.1f ns/pt  release p50 %8.2f us  p99 %8.2f us  "
+                       "deviation %.3f\n",
+                       mode,
+                       stroke.name.c_str(),
+                       count,
+                       add.p50,
+                       release.p50,
+                       release.p99,
+                       deviation);
+                results.push_back({
+                        {"section", "resample"},
+                        {"mode", mode},
+                        {"stroke", stroke.name},
+                        {"points", count},
+                        {"add_p50_ns_per_point", add.p50},
+                        {"add_mean_ns_per_point", add.mean},
+                        {"release_p50_us", release.p50},
+                        {"release_p99_us", release.p99},
+                        {"release_mean_us", release.mean},
+                        {"max_deviation", deviation},
+                });
+            }
+        }
+    }
+    return results;
+}
+
+// Compares the Protractor and golden-section decisions on the corpus and finds the Protractor threshold
+// that accepts and rejects the same strokes as the golden-section one
+nlohmann::json benchMatchers(const Options& options) {
+    struct Match {
+        const char* shape;
+        double goldenDistance;
+        double protractorDistance;
+        IGestureRecognizer::Direction goldenDirection;
+        IGestureRecognizer::Direction protractorDirection;
+    };
+    const double goldenThreshold = Thresholds::UNISTROKE_THRESHOLD;
+
+    UnistrokeRecognizer golden(UnistrokeRecognizer::Matcher::GoldenSection);
+    UnistrokeRecognizer protractor(UnistrokeRecognizer::Matcher::Protractor);
+    const std::vector<Stroke> corpus = GestureCorpus(3).generate(static_cast<size_t>(options.corpus));
+    std::vector<Match> matches;
+    for (const Stroke& stroke : corpus) {
+        Match match;
+        match.shape = stroke.name.c_str();
+        match.goldenDistance = golden.closestTemplate(stroke.points, match.goldenDirection);
+        match.protractorDistance = protractor.closestTemplate(stroke.points, match.protractorDirection);
+        matches.push_back(match);
+    }
+
+    // Outcomes with a Protractor threshold: both accept the same direction, both reject, or they disagree
+    struct Agreement {
+        size_t bothAccept = 0;
+        size_t bothReject = 0;
+        size_t goldenOnly = 0;
+        size_t protractorOnly = 0;
+        size_t otherDirection = 0;
+    };
+    auto agreementAt = [&matches, goldenThreshold](double threshold) {
+        Agreement agreement;
+        for (const Match& match : matches) {
+            bool goldenAccepts = match.goldenDistance < goldenThreshold;
+            bool protractorAccepts = match.protractorDistance < threshold;
+            if (goldenAccepts && protractorAccepts) {
+                if (match.goldenDirection == match.protractorDirection) {
+                    agreement.bothAccept++;
+                } else {
+                    agreement.otherDirection++;
+                }
+            } else if (goldenAccepts) {
+                agreement.goldenOnly++;
+            } else if (protractorAccepts) {
+                agreement.protractorOnly++;
+            } else {
+                agreement.bothReject++;
+            }
+        }
+        return agreement;
+    };
+
+    double bestThreshold = 0.0;
+    size_t fewestDisagreements = matches.size() + 1;
+    for (int step = 1; step <= 160; ++step) {
+        double threshold = step * 0.01;
+        Agreement agreement = agreementAt(threshold);
+        size_t disagreements = agreement.goldenOnly + agreement.protractorOnly + agreement.otherDirection;
+        if (disagreements < fewestDisagreements) {
+            fewestDisagreements = disagreements;
+            bestThreshold = threshold;
+        }
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+    auto report = [&](const char* name, double threshold) {
+        Agreement agreement = agreementAt(threshold);
+        printf("matchers %-10s threshold %.2f rad  both accept %zu  both reject %zu  golden only %zu  "
+               "protractor only %zu  other direction %zu\n",
+               name,
+               threshold,
+               agreement.bothAccept,
+               agreement.bothReject,
+               agreement.goldenOnly,
+               agreement.protractorOnly,
+               agreement.otherDirection);
+        results.push_back({
+                {"section", "matchers"},
+                {"threshold_name", name},
+                {"protractor_threshold", threshold},
+                {"golden_threshold", goldenThreshold},
+                {"strokes", matches.size()},
+                {"both_accept", agreement.bothAccept},
+                {"both_reject", agreement.bothReject},
+                {"golden_only", agreement.goldenOnly},
+                {"protractor_only", agreement.protractorOnly},
+                {"other_direction", agreement.otherDirection},
+        });
+    };
+    report("configured", Thresholds::PROTRACTOR_THRESHOLD);
+    report("calibrated", bestThreshold);
+
+    // Acceptance per shape with the calibrated threshold
+    std::vector<std::string> shapes;
+    for (const Match& match : matches) {
+        if (!contains(shapes, match.shape)) {
+            shapes.push_back(match.shape);
+        }
+    }
+    for (const std::string& shape : shapes) {
+        size_t total = 0;
+        size_t goldenAccepts = 0;
+        size_t protractorAccepts = 0;
+        size_t sameDirection = 0;
+        for (const Match& match : matches) {
+            if (shape == match.shape) {
+                total++;
+                goldenAccepts += match.goldenDistance < goldenThreshold ? 1 : 0;
+                protractorAccepts += match.protractorDistance < bestThreshold ? 1 : 0;
+                sameDirection += match.goldenDirection == match.protractorDirection ? 1 : 0;
+            }
+        }
+        printf("matchers %-12s accepted by golden-section %4zu / protractor %4zu, same direction %4zu of %zu\n",
+               shape.c_str(),
+               goldenAccepts,
+               protractorAccepts,
+               sameDirection,
+               total);
+    }
+    return results;
+}
+
+// Cost of the golden-section search against a growing template library with each of its pruning stages,
+// from the exhaustive search to the full cascade, and the decisions that differ from the exhaustive search
+nlohmann::json benchSearch(const Options& options) {
+    struct Stages {
+        const char* name;
+        uint32_t flags;
+    };
+    const Stages stageSets[] = {
+            {"exhaustive", 0},
+            {"early_abandon", UnistrokeRecognizer::EARLY_ABANDON},
+            {"prefilter", UnistrokeRecognizer::PREFILTER | UnistrokeRecognizer::EARLY_ABANDON},
+            {"radius_bounds", UnistrokeRecognizer::RADIUS_BOUNDS | UnistrokeRecognizer::EARLY_ABANDON},
+            {"all", UnistrokeRecognizer::ALL_SEARCH_STAGES},
+    };
+    const IGestureRecognizer::Direction directions[] = {
+            IGestureRecognizer::Direction::Right,
+            IGestureRecognizer::Direction::Left,
+            IGestureRecognizer::Direction::Down,
+            IGestureRecognizer::Direction::Up,
+    };
+
+    // Recorded templates are strokes of every shape, so many of them are close to any query
+    int largest = 0;
+    for (int count : options.templates) {
+        largest = std::max(largest, count);
+    }
+    std::vector<UnistrokeRecognizer::GestureTemplate> recorded(static_cast<size_t>(largest));
+    const std::vector<Stroke> templateStrokes = GestureCorpus(5).generate(static_cast<size_t>(largest / 8 + 1));
+    UnistrokeRecognizer builder;
+    for (size_t i = 0; i < recorded.size(); ++i) {
+        builder.createTemplate(templateStrokes[i].points, directions[i % 4], recorded[i]);
+    }
+    const std::vector<Stroke> queries = GestureCorpus(6).generate(static_cast<size_t>(options.queries));
+
+    nlohmann::json results = nlohmann::json::array();
+    for (int count : options.templates) {
+        GestureLibrary library;
+        library.assign(recorded.data(), static_cast<size_t>(count));
+        std::vector<IGestureRecognizer::Direction> exhaustiveDecisions;
+        for (const Stages& stages : stageSets) {
+            UnistrokeRecognizer recognizer;
+            recognizer.setTemplateLibrary(&library);
+            recognizer.setSearchStages(stages.flags);
+            std::vector<double> samples;
+            samples.reserve(queries.size());
+            size_t changed = 0;
+            for (size_t i = 0; i < queries.size(); ++i) {
+                auto start = std::chrono::steady_clock::now();
+                IGestureRecognizer::Direction direction = recognizer.recognize(queries[i].points);
+                samples.push_back(elapsedMicroseconds(start));
+                if (stages.flags == 0) {
+                    exhaustiveDecisions.push_back(direction);
+                } else if (direction != exhaustiveDecisions[i]) {
+                    changed++;
+                }
+            }
+            const UnistrokeRecognizer::SearchStats& stats = recognizer.searchStats();
+            const double strokes = static_cast<double>(stats.recognitions);
+            // Point distances summed, in full searches: a prefilter search costs the ratio of the resolutions
+            const double prefilterCost = static_cast<double>(Resolutions::PREFILTER_POINTS) / Resolutions::NUM_POINTS;
+            const double work = (stats.fullSearches + stats.prefilterSearches * prefilterCost) / strokes;
+            Summary summary = summarize(samples);
+            printf("search   %4d templates  %-13s  p50 %8.1f us  p99 %8.1f us  mean %8.1f us  "
+                   "full searches %7.1f  prefilter searches %7.1f  work %7.1f  changed %zu\n",
+                   count + 4,
+                   stages.name,
+                   summary.p50,
+                   summary.p99,
+                   summary.mean,
+                   stats.fullSearches / strokes,
+                   stats.prefilterSearches / strokes,
+                   work,
+                   changed);
+            results.push_back({
+                    {"section", "search"},
+                    {"stages", stages.name},
+                    {"templates", count + 4},
+                    {"strokes", queries.size()},
+                    {"p50_us", summary.p50},
+                    {"p99_us", summary.p99},
+                    {"mean_us", summary.mean},
+                    {"full_searches_per_stroke", stats.fullSearches / strokes},
+                    {"prefilter_searches_per_stroke", stats.prefilterSearches / strokes},
+                    {"work_per_stroke", work},
+                    {"changed_decisions", changed},
+            });
+        }
+    }
+    return results;
+}
+
+// Replays strokes through GestureAnalyzer as the hook callback does: analyzeEarly after every move, and
+// analyzeGesture on release unless the gesture was committed early. Moves are spaced like a 125 Hz mouse.
+nlohmann::json benchEarlyCommit(const Options& options) {
+    constexpr uint32_t MOVE_INTERVAL_MS = 8;
+    struct CommitLimits {
+        double confidence;
+        double distance;
+    };
+    const CommitLimits limitSets[] = {{0.8, 100.0}, {0.9, 200.0}, {0.95, 300.0}};
+    const std::vector<Stroke> strokes = GestureCorpus(7).generate(static_cast<size_t>(options.queries));
+
+    nlohmann::json results = nlohmann::json::array();
+    for (const char* engine : {"simple", "unistroke", "protractor"}) {
+        for (const CommitLimits& limits : limitSets) {
+            GestureAnalyzer analyzer;
+            analyzer.setRecognizer(engine);
+            size_t committed = 0;
+            size_t differing = 0;  // Early decisions that the decision on release would not have made
+            size_t loops = 0;      // Commits on strokes that come back towards where they started
+            size_t swipes = 0;     // Straight and wavy swipes, the gestures early commit is meant for
+            size_t swipesCommitted = 0;
+            size_t moves = 0;
+            double analyzeTime = 0.0;
+            std::vector<double> saved;
+            for (const Stroke& stroke : strokes) {
+                const bool swipe = stroke.name == "line" || stroke.name == "wave";
+                swipes += swipe ? 1 : 0;
+                analyzer.clearPositions();
+                IGestureRecognizer::Direction early = IGestureRecognizer::Direction::None;
+                size_t commitIndex = 0;
+                uint32_t time = 0;
+                for (size_t i = 0; i < stroke.points.size(); ++i) {
+                    analyzer.addPosition(stroke.points[i].first, stroke.points[i].second, time += MOVE_INTERVAL_MS);
+                    if (early != IGestureRecognizer::Direction::None) {
+                        continue;
+                    }
+                    auto start = std::chrono::steady_clock::now();
+                    early = analyzer.analyzeEarly(limits.confidence, limits.distance);
+                    analyzeTime += elapsedMicroseconds(start);
+                    moves++;
+                    commitIndex = i;
+                }
+                if (early == IGestureRecognizer::Direction::None) {
+                    continue;
+                }
+                committed++;
+                swipesCommitted += swipe ? 1 : 0;
+                if (analyzer.analyzeGesture() != early) {
+                    differing++;
+                }
+                if (stroke.name == "circle" || stroke.name == "out_and_back") {
+                    loops++;
+                }
+                // Motion left after the commit; the time the button is held after the motion ends is saved too
+                saved.push_back(static_cast<double>((stroke.points.size() - 1 - commitIndex) * MOVE_INTERVAL_MS));
+            }
+
+            Summary summary = saved.empty() ? Summary{0.0, 0.0, 0.0} : summarize(saved);
+            const double commitRate = static_cast<double>(committed) / strokes.size();
+            const double swipeCommitRate = static_cast<double>(swipesCommitted) / swipes;
+            const double analyzeCost = moves ? analyzeTime / moves : 0.0;
+            printf("early    %-10s  confidence %.2f  distance %3.0f  committed %5.1f%%  swipes %5.1f%%  differing %4zu  loops %4zu  "
+                   "saved p50 %5.0f ms  mean %5.0f ms  analyzeEarly %6.2f us\n",
+                   engine,
+                   limits.confidence,
+                   limits.distance,
+                   100.0 * commitRate,
+                   100.0 * swipeCommitRate,
+                   differing,
+                   loops,
+                   summary.p50,
+                   summary.mean,
+                   analyzeCost);
+            results.push_back({
+                    {"section", "early"},
+                    {"engine", engine},
+                    {"confidence", limits.confidence},
+                    {"distance", limits.distance},
+                    {"strokes", strokes.size()},
+                    {"commit_rate", commitRate},
+                    {"swipe_commit_rate", swipeCommitRate},
+                    {"differing_decisions", differing},
+                    {"committed_loops", loops},
+                    {"saved_p50_ms", summary.p50},
+                    {"saved_mean_ms", summary.mean},
+                    {"analyze_early_us", analyzeCost},
+            });
+        }
+    }
+    return results;
+}
+
+volatile double g_sink;  // Keeps the results of timed kernel calls alive
+
+// Cost of one call of every kernel of every supported instruction set on paths of 16 and 64 points,
+// the prefilter and full resolutions, and the largest relative difference of its results from scalar
+nlohmann::json benchKernels(const Options& options) {
+    constexpr int CALLS_PER_SAMPLE = 1000;
+    std::mt19937 random(4);
+    std::uniform_real_distribution<double> coordinate(-125.0, 125.0);
+    GesturePath a;
+    GesturePath b;
+    GesturePath rotated;
+    for (size_t i = 0; i < GesturePath::CAPACITY; ++i) {
+        a.push_back(Point(coordinate(random), coordinate(random)));
+        b.push_back(Point(coordinate(random), coordinate(random)));
+    }
+    const double noLimit = std::numeric_limits<double>::infinity();
+    const GestureKernels& scalar = scalarGestureKernels();
+
+    nlohmann::json results = nlohmann::json::array();
+    for (size_t count : {size_t(16), size_t(64)}) {
+        // Results of each kernel, compared with the scalar ones relative to their magnitude
+        auto distanceOutputs = [&](const GestureKernels& kernels) {
+            return std::vector<double>{kernels.pathDistance(a.x, a.y, b.x, b.y, count, noLimit)};
+        };
+        auto sumOutputs = [&](const GestureKernels& kernels) {
+            double sumX = 0.0;
+            double sumY = 0.0;
+            kernels.coordinateSum(a.x, a.y, count, sumX, sumY);
+            return std::vector<double>{sumX, sumY};
+        };
+        auto rotateOutputs = [&](const GestureKernels& kernels) {
+            kernels.rotate(a.x, a.y, count, 0.955, 0.296, 1.0, 2.0, rotated.x, rotated.y);
+            std::vector<double> values(rotated.x, rotated.x + count);
+            values.insert(values.end(), rotated.y, rotated.y + count);
+            return values;
+        };
+        auto boundsOutputs = [&](const GestureKernels& kernels) {
+            PathBounds bounds = kernels.bounds(a.x, a.y, count);
+            return std::vector<double>{bounds.minX, bounds.minY, bounds.maxX, bounds.maxY};
+        };
+
+        for (const GestureKernels* kernels : supportedGestureKernels()) {
+            auto time = [&](const char* kernel, auto outputs, auto call) {
+                std::vector<double> expected = outputs(scalar);
+                std::vector<double> actual = outputs(*kernels);
+                double error = 0.0;
+                for (size_t i = 0; i < expected.size(); ++i) {
+                    error = std::max(error, std::abs(actual[i] - expected[i]) / std::max(1.0, std::abs(expected[i])));
+                }
+
+                std::vector<double> samples;
+                samples.reserve(static_cast<size_t>(options.repeats));
+                for (int repeat = 0; repeat < options.repeats; ++repeat) {
+                    auto start = std::chrono::steady_clock::now();
+                    for (int i = 0; i < CALLS_PER_SAMPLE; ++i) {
+                        call();
+                    }
+                    samples.push_back(elapsedMicroseconds(start) * 1000.0 / CALLS_PER_SAMPLE);
+                }
+                Summary summary = summarize(samples);
+                printf("kernels  %-6s %-14s %2zu pts  p50 %6.1f ns  p99 %6.1f ns  max relative error %.1e\n",
+                       kernels->name,
+                       kernel,
+                       count,
+                       summary.p50,
+                       summary.p99,
+                       error);
+                results.push_back({
+                        {"section", "kernels"},
+                        {"kernels", kernels->name},
+                        {"kernel", kernel},
+                        {"points", count},
+                        {"p50_ns", summary.p50},
+                        {"p99_ns", summary.p99},
+                        {"mean_ns", summary.mean},
+                        {"max_relative_error", error},
+                });
+            };
+            time("path_distance", distanceOutputs, [&] {
+                g_sink = kernels->pathDistance(a.x, a.y, b.x, b.y, count, noLimit);
+            });
+            time("coordinate_sum", sumOutputs, [&] {
+                double sumX = 0.0;
+                double sumY = 0.0;
+                kernels->coordinateSum(a.x, a.y, count, sumX, sumY);
+                g_sink = sumX + sumY;
+            });
+            time("rotate", rotateOutputs, [&] {
+                kernels->rotate(a.x, a.y, count, 0.955, 0.296, 1.0, 2.0, rotated.x, rotated.y);
+                g_sink = rotated.x[0];
+            });
+            time("bounds", boundsOutputs, [&] {
+                g_sink = kernels->bounds(a.x, a.y, count).maxX;
+            });
+        }
+    }
+    return results;
+}
+
+void printUsage() {
+    printf("Usage: recognizer_bench [options]\n"
+           "  --out FILE        JSON results file (default recognizer_bench.json)\n"
+           "  --sections LIST   resample,matchers,kernels,search,early\n"
+           "  --points LIST     Stroke lengths for resample (default 10,100,1000,10000)\n"
+           "  --repeats N       Timed repetitions per case, of 1000 calls for kernels (default 200)\n"
+           "  --corpus N        Synthetic gestures of each shape for matchers (default 500)\n"
+           "  --queries N       Synthetic gestures of each shape for search and early (default 100)\n"
+           "  --templates LIST  Recorded templates added to the 4 built-in ones for search (default 0,16,64,256,1024)\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--out") {
+            options.outPath = value;
+        } else if (arg == "--sections") {
+            options.sections = splitList(value);
+        } else if (arg == "--points") {
+            options.points = parseIntList(value);
+        } else if (arg == "--repeats") {
+            options.repeats = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--corpus") {
+            options.corpus = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--queries") {
+            options.queries = std::max(1, std::atoi(value.c_str()));
+        } else if (arg == "--templates") {
+            options.templates = parseIntList(value);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int runBenchmarks(const Options& options) {
+    nlohmann::json results = nlohmann::json::array();
+    auto append = [&results](const nlohmann::json& section) {
+        results.insert(results.end(), section.begin(), section.end());
+    };
+    if (contains(options.sections, "resample")) {
+        append(benchResample(options));
+    }
+    if (contains(options.sections, "matchers")) {
+        append(benchMatchers(options));
+    }
+    if (contains(options.sections, "kernels")) {
+        append(benchKernels(options));
+    }
+    if (contains(options.sections, "search")) {
+        append(benchSearch(options));
+    }
+    if (contains(options.sections, "early")) {
+        append(benchEarlyCommit(options));
+    }
+
+    nlohmann::json document = {
+            {"benchmark", "recognizer"},
+            {"version", 1},
+            {"results", results},
+    };
+    std::ofstream out(options.outPath);
+    out << document.dump(2) << '\n';
+    if (!out) {
+        fprintf(stderr, "Failed to write %s\n", options.outPath.c_str());
+        return 1;
+    }
+    printf("%zu results written to %s\n", results.size(), options.outPath.c_str());
+    return 0;
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main(int argc, char** argv) {
+    VirtualDesktop::Options options;
+    if (!VirtualDesktop::parseOptions(argc, argv, options)) {
+        VirtualDesktop::printUsage();
+        return 2;
+    }
+    return VirtualDesktop::runBenchmarks(options);
+}
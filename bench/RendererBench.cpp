@@ -0,0 +1,746 @@
+// Replays strokes through the renderers and the overlay and writes the cost of every frame as JSON
+#include "HeadlessRenderer.h"
+#include "StrokeRasterizer.h"
+#include "TiledSurface.h"
+#include "WorkerPool.h"
+#include "nlohmann/json.hpp"
+#ifdef _WIN32
+#include "GdiRenderer.h"
+#include "OverlayUI.h"
+#include "Settings.h"
+#include <Windows.h>
+#endif
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};  // Heap allocations made anywhere in the process
+}  // namespace
+
+// Count every allocation; the renderers are compiled into this executable, so theirs are included
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    std::free(block);
+}
+
+namespace VirtualDesktop {
+namespace {
+
+using Point = TrailCanvas::Point;
+
+constexpr size_t MIN_APPEND_FRAMES = 1000;  // A short stroke is replayed until it made this many frames
+constexpr size_t POOL_TILE_COUNTS[] = {2, 4, 8, 16, 32, 64, 128};
+constexpr int POOL_RUNS = 400;  // Timed runs per tile count and way of drawing
+
+struct Screen {
+    std::string name;
+    int left;
+    int top;
+    int width;
+    int height;
+};
+
+// Simulated virtual screens; the 3x4K desk has its primary monitor in the middle
+const Screen SIMULATED_SCREENS[] = {
+        {"1080p", 0, 0, 1920, 1080},
+        {"4K", 0, 0, 3840, 2160},
+        {"3x4K", -3840, 0, 11520, 2160},
+};
+
+struct Stroke {
+    std::string name;
+    std::vector<Point> points;  // Relative to the top-left corner of the virtual screen
+};
+
+struct Options {
+    std::string outPath = "renderer_bench.json";
+    std::string strokesPath;
+    std::vector<std::string> backends = {"headless", "pool", "gdi", "overlay"};
+    std::vector<std::string> screens = {"1080p", "4K", "3x4K"};
+    std::vector<int> points = {10, 100, 1000, 10000};
+    std::vector<int> lineWidths = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    std::vector<int> threads = {0};
+    int renderFrames = 20;
+};
+
+struct Measurement {
+    std::vector<double> frameMicroseconds;
+    uint64_t allocations = 0;
+    bool hasFrameStats = false;  // Whether the backend reported pixels and bytes
+    FrameStats stats = {};
+    size_t surfaceBytes = 0;
+};
+
+// What a benchmark drives: the trail of one renderer backend, in screen coordinates
+class Target {
+public:
+    virtual ~Target() = default;
+    virtual void render(const std::vector<Point>& points) = 0;
+    virtual void append(Point point) = 0;
+    virtual void clear() = 0;
+    virtual size_t surfaceBytes() const = 0;
+    // Running totals of the backend's own statistics, or nullptr if it records none
+    virtual const FrameStats* totals() const {
+        return nullptr;
+    }
+};
+
+class HeadlessTarget : public Target {
+public:
+    HeadlessTarget(const Screen& screen, int lineWidth, int threads) {
+        m_renderer.setScreen(screen.left, screen.top, screen.width, screen.height);
+        m_renderer.setTrailStyle("#6495EDAA", static_cast<float>(lineWidth));
+        m_renderer.setThreads(static_cast<unsigned>(threads));
+        m_renderer.prepare();
+    }
+
+    void render(const std::vector<Point>& points) override {
+        m_renderer.render(points.data(), points.size());
+    }
+
+    void append(Point point) override {
+        m_renderer.append(point);
+    }
+
+    void clear() override {
+        m_renderer.clear();
+    }
+
+    size_t surfaceBytes() const override {
+        return m_renderer.surfaceBytes();
+    }
+
+    const FrameStats* totals() const override {
+        return &m_renderer.totals();
+    }
+
+private:
+    HeadlessRenderer m_renderer;
+};
+
+#ifdef _WIN32
+// GdiRenderer presenting into a click-through layered window over the real virtual screen
+class GdiTarget : public Target {
+public:
+    GdiTarget(const Screen& screen, int lineWidth) {
+        m_hwnd = CreateWindowExW(
+                WS_EX_LAYERED | WS_EX_TRANSPARENT | WS_EX_TOPMOST | WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE,
+                L"STATIC",
+                L"",
+                WS_POPUP,
+                screen.left,
+                screen.top,
+                screen.width,
+                screen.height,
+                nullptr,
+                nullptr,
+                GetModuleHandle(nullptr),
+                nullptr);
+        ShowWindow(m_hwnd, SW_SHOWNOACTIVATE);
+        m_renderer.setTrailStyle("#6495EDAA", static_cast<float>(lineWidth));
+        m_renderer.initialize(m_hwnd);
+        m_renderer.prepare();
+    }
+
+    ~GdiTarget() override {
+        m_renderer.trim();
+        if (m_hwnd) {
+            DestroyWindow(m_hwnd);
+        }
+    }
+
+    void render(const std::vector<Point>& points) override {
+        m_points.clear();
+        for (const Point& point : points) {
+            m_points.push_back({point.x, point.y});
+        }
+        m_renderer.render(m_points);
+    }
+
+    void append(Point point) override {
+        m_renderer.append({point.x, point.y});
+    }
+
+    void clear() override {
+        m_renderer.clear();
+    }
+
+    size_t surfaceBytes() const override {
+        return m_renderer.surfaceBytes();
+    }
+
+private:
+    HWND m_hwnd;
+    GdiRenderer m_renderer;
+    std::vector<POINT> m_points;
+};
+
+Screen desktopScreen() {
+    return {"desktop",
+            GetSystemMetrics(SM_XVIRTUALSCREEN),
+            GetSystemMetrics(SM_YVIRTUALSCREEN),
+            GetSystemMetrics(SM_CXVIRTUALSCREEN),
+            GetSystemMetrics(SM_CYVIRTUALSCREEN)};
+}
+
+void pumpMessages() {
+    MSG msg;
+    while (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+        TranslateMessage(&msg);
+        DispatchMessage(&msg);
+    }
+}
+#endif
+
+// Fast swipe across 90% of the screen width with a vertical wobble: the stroke with the largest dirty area
+Stroke makeSwipe(size_t count, const Screen& screen) {
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> jitter(-2, 2);
+    Stroke stroke = {"swipe", {}};
+    for (size_t i = 0; i < count; ++i) {
+        double t = count > 1 ? static_cast<double>(i) / static_cast<double>(count - 1) : 0.0;
+        double x = screen.width * (0.05 + 0.9 * t);
+        double y = screen.height * (0.5 + 0.3 * std::sin(t * 12.0));
+        stroke.points.push_back({static_cast<int32_t>(x) + jitter(random), static_cast<int32_t>(y) + jitter(random)});
+    }
+    return stroke;
+}
+
+// Random walk of 8 px steps that turns gradually and stays away from the edges: a typical drawn gesture
+Stroke makeScribble(size_t count, const Screen& screen) {
+    std::mt19937 random(2);
+    std::uniform_real_distribution<double> turn(-0.3, 0.3);
+    Stroke stroke = {"scribble", {}};
+    double x = screen.width / 2.0;
+    double y = screen.height / 2.0;
+    double angle = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        angle += turn(random);
+        x += 8.0 * std::cos(angle);
+        y += 8.0 * std::sin(angle);
+        if (x < 100.0 || x > screen.width - 100.0) {
+            angle = 3.14159265358979 - angle;
+        }
+        if (y < 100.0 || y > screen.height - 100.0) {
+            angle = -angle;
+        }
+        stroke.points.push_back({static_cast<int32_t>(x), static_cast<int32_t>(y)});
+    }
+    return stroke;
+}
+
+// Recorded strokes: one "x y" pair per line, relative to the virtual screen, with blank lines between strokes
+std::vector<Stroke> loadStrokes(const std::string& path) {
+    std::vector<Stroke> strokes;
+    std::ifstream file(path);
+    std::string line;
+    Stroke stroke;
+    auto finish = [&]() {
+        if (!stroke.points.empty()) {
+            stroke.name = "recorded-" + std::to_string(strokes.size());
+            strokes.push_back(std::move(stroke));
+            stroke = Stroke();
+        }
+    };
+    while (std::getline(file, line)) {
+        std::istringstream values(line);
+        Point point;
+        if (values >> point.x >> point.y) {
+            stroke.points.push_back(point);
+        } else {
+            finish();
+        }
+    }
+    finish();
+    return strokes;
+}
+
+std::vector<Point> toScreen(const Stroke& stroke, const Screen& screen) {
+    std::vector<Point> points;
+    for (const Point& point : stroke.points) {
+        points.push_back({point.x + screen.left, point.y + screen.top});
+    }
+    return points;
+}
+
+double elapsedMicroseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Cost of redrawing the whole trail with render(), after one warm-up frame
+Measurement measureRender(Target& target, const std::vector<Point>& points, int frames) {
+    Measurement result;
+    result.frameMicroseconds.reserve(static_cast<size_t>(frames));
+    target.render(points);
+    FrameStats before = target.totals() ? *target.totals() : FrameStats{};
+    uint64_t allocations = g_allocations.load();
+    for (int frame = 0; frame < frames; ++frame) {
+        auto start = std::chrono::steady_clock::now();
+        target.render(points);
+        result.frameMicroseconds.push_back(elapsedMicroseconds(start));
+    }
+    result.allocations = g_allocations.load() - allocations;
+    if (const FrameStats* after = target.totals()) {
+        result.hasFrameStats = true;
+        result.stats = {
+                after->nanoseconds - before.nanoseconds,
+                after->tilesDrawn - before.tilesDrawn,
+                after->pixelsTouched - before.pixelsTouched,
+                after->bytesPresented - before.bytesPresented};
+    }
+    result.surfaceBytes = target.surfaceBytes();
+    target.clear();
+    return result;
+}
+
+// Cost of drawing the stroke as it is made, one append() per position
+Measurement measureAppend(Target& target, const std::vector<Point>& points) {
+    Measurement result;
+    size_t replays = std::max<size_t>(1, MIN_APPEND_FRAMES / std::max<size_t>(points.size(), 1));
+    result.frameMicroseconds.reserve(replays * points.size());
+    const std::vector<Point> first = {points.front()};
+    FrameStats before = target.totals() ? *target.totals() : FrameStats{};
+    uint64_t allocations = g_allocations.load();
+    for (size_t replay = 0; replay < replays; ++replay) {
+        target.render(first);
+        for (size_t i = 1; i < points.size(); ++i) {
+            auto start = std::chrono::steady_clock::now();
+            target.append(points[i]);
+            result.frameMicroseconds.push_back(elapsedMicroseconds(start));
+        }
+        result.surfaceBytes = std::max(result.surfaceBytes, target.surfaceBytes());
+        target.clear();
+    }
+    result.allocations = g_allocations.load() - allocations;
+    if (const FrameStats* after = target.totals()) {
+        // The untimed render() and clear() frames of each replay draw nothing and present only the clears
+        result.hasFrameStats = true;
+        result.stats = {
+                after->nanoseconds - before.nanoseconds,
+                after->tilesDrawn - before.tilesDrawn,
+                after->pixelsTouched - before.pixelsTouched,
+                after->bytesPresented - before.bytesPresented};
+    }
+    return result;
+}
+
+#ifdef _WIN32
+// Cost of OverlayUI::updatePosition() per position, with the renderer the settings select
+Measurement measureOverlay(OverlayUI& overlay, Settings& settings, const std::vector<Point>& points) {
+    Measurement result;
+    settings.setStrokeCapacity(static_cast<int>(std::max<size_t>(points.size(), 64)));
+    overlay.setSettings(settings);
+    size_t replays = std::max<size_t>(1, MIN_APPEND_FRAMES / std::max<size_t>(points.size(), 1));
+    result.frameMicroseconds.reserve(replays * points.size());
+    uint64_t allocations = g_allocations.load();
+    for (size_t replay = 0; replay < replays; ++replay) {
+        overlay.show();
+        for (const Point& point : points) {
+            auto start = std::chrono::steady_clock::now();
+            overlay.updatePosition(point.x, point.y);
+            result.frameMicroseconds.push_back(elapsedMicroseconds(start));
+        }
+        result.surfaceBytes = std::max(result.surfaceBytes, overlay.surfaceBytes());
+        overlay.hide();
+        pumpMessages();
+    }
+    result.allocations = g_allocations.load() - allocations;
+    return result;
+}
+#endif
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double fraction) {
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    return sorted[std::min(sorted.size(), std::max<size_t>(rank, 1)) - 1];
+}
+
+double median(std::vector<double> samples) {
+    std::sort(samples.begin(), samples.end());
+    return percentile(samples, 0.5);
+}
+
+/**
+ * Drawing a frame's tiles on the calling thread against spreading them over a WorkerPool, the trade-off behind
+ * TrailCanvas's PARALLEL_MIN_TILES. Each tile is cleared and crossed by a segment, as render() draws it. The
+ * dispatch overhead is the parallel time beyond the serial time divided by the cores that can work at once, and
+ * the break-even is the tile count whose saving on as many cores as threads pays for it.
+ */
+void measurePool(const Options& options, nlohmann::json& results) {
+    const int size = TiledSurface::TILE_SIZE;
+    const size_t maxTiles = *std::max_element(std::begin(POOL_TILE_COUNTS), std::end(POOL_TILE_COUNTS));
+    const int lineWidth = options.lineWidths.empty() ? 5 : options.lineWidths.front();
+    StrokeRasterizer rasterizer;
+    rasterizer.setStyle(0x6495ED, 0xAA, static_cast<float>(lineWidth));
+    std::vector<uint32_t> pixels(maxTiles * TiledSurface::TILE_PIXELS);
+    const std::function<void(size_t)> drawTile = [&](size_t i) {
+        uint32_t* tile = pixels.data() + i * TiledSurface::TILE_PIXELS;
+        memset(tile, 0, TiledSurface::TILE_BYTES);
+        rasterizer.drawSegment(tile, size, 0, 0, size, size, -8.0f, 20.0f, 72.0f, 44.0f);
+    };
+
+    const unsigned cores = std::max(1u, std::thread::hardware_concurrency());
+    for (int requested : options.threads) {
+        WorkerPool pool;
+        pool.setThreads(static_cast<unsigned>(std::max(requested, 0)));
+        const unsigned threads = pool.threads();
+        if (threads <= 1) {
+            continue;
+        }
+        const double working = static_cast<double>(std::min(threads, cores));
+        std::vector<double> tileMicroseconds;
+        std::vector<double> overheads;
+        for (size_t tiles : POOL_TILE_COUNTS) {
+            // Alternate the two ways of drawing, so both see the same state of the machine
+            std::vector<double> serial;
+            std::vector<double> parallel;
+            pool.run(tiles, drawTile);
+            for (int run = 0; run < POOL_RUNS; ++run) {
+                auto start = std::chrono::steady_clock::now();
+                for (size_t i = 0; i < tiles; ++i) {
+                    drawTile(i);
+                }
+                serial.push_back(elapsedMicroseconds(start));
+                start = std::chrono::steady_clock::now();
+                pool.run(tiles, drawTile);
+                parallel.push_back(elapsedMicroseconds(start));
+            }
+            const double serialUs = median(serial);
+            const double parallelUs = median(parallel);
+            const double overhead = parallelUs - serialUs / working;
+            tileMicroseconds.push_back(serialUs / static_cast<double>(tiles));
+            overheads.push_back(overhead);
+            results.push_back({
+                    {"backend", "pool"},
+                    {"mode", "tiles"},
+                    {"tiles", tiles},
+                    {"threads", threads},
+                    {"line_width", lineWidth},
+                    {"serial_p50_us", serialUs},
+                    {"parallel_p50_us", parallelUs},
+                    {"overhead_us", overhead},
+            });
+            printf("pool     tiles %4zu  t=%u  serial p50 %8.1f us  parallel p50 %8.1f us  speedup %5.2f  "
+                   "overhead %6.1f us\n",
+                   tiles,
+                   threads,
+                   serialUs,
+                   parallelUs,
+                   serialUs / parallelUs,
+                   overhead);
+        }
+
+        const double tileUs = median(tileMicroseconds);
+        const double overhead = median(overheads);
+        const double breakEven = overhead / (tileUs * (1.0 - 1.0 / threads));
+        results.push_back({
+                {"backend", "pool"},
+                {"mode", "break_even"},
+                {"threads", threads},
+                {"line_width", lineWidth},
+                {"tile_us", tileUs},
+                {"overhead_us", overhead},
+                {"break_even_tiles", breakEven},
+        });
+        printf("pool     t=%u  %.2f us per tile, %.1f us dispatch overhead: break-even at %.1f tiles on %u cores\n",
+               threads,
+               tileUs,
+               overhead,
+               breakEven,
+               threads);
+        fflush(stdout);
+    }
+}
+
+nlohmann::json report(
+        const std::string& backend,
+        const std::string& mode,
+        const std::string& stroke,
+        size_t points,
+        const Screen& screen,
+        int lineWidth,
+        int threads,
+        Measurement& result) {
+    std::vector<double>& samples = result.frameMicroseconds;
+    std::sort(samples.begin(), samples.end());
+    const double frames = static_cast<double>(std::max<size_t>(samples.size(), 1));
+    double total = 0.0;
+    for (double sample : samples) {
+        total += sample;
+    }
+
+    nlohmann::json entry = {
+            {"backend", backend},
+            {"mode", mode},
+            {"stroke", stroke},
+            {"points", points},
+            {"screen", screen.name},
+            {"screen_width", screen.width},
+            {"screen_height", screen.height},
+            {"line_width", lineWidth},
+            {"threads", threads},
+            {"frames", samples.size()},
+            {"p50_us", samples.empty() ? 0.0 : percentile(samples, 0.5)},
+            {"p99_us", samples.empty() ? 0.0 : percentile(samples, 0.99)},
+            {"mean_us", total / frames},
+            {"allocations_per_frame", static_cast<double>(result.allocations) / frames},
+            {"surface_bytes", result.surfaceBytes},
+            {"pixels_per_frame", nullptr},
+            {"bytes_presented_per_frame", nullptr},
+    };
+    if (result.hasFrameStats) {
+        entry["pixels_per_frame"] = static_cast<double>(result.stats.pixelsTouched) / frames;
+        entry["bytes_presented_per_frame"] = static_cast<double>(result.stats.bytesPresented) / frames;
+    }
+
+    printf("%-8s %-15s %-11s %6zu pts %-7s w=%-2d t=%d  p50 %10.1f us  p99 %10.1f us  px/frame %10.0f  "
+           "allocs/frame %.3f\n",
+           backend.c_str(),
+           mode.c_str(),
+           stroke.c_str(),
+           points,
+           screen.name.c_str(),
+           lineWidth,
+           threads,
+           entry["p50_us"].get<double>(),
+           entry["p99_us"].get<double>(),
+           result.hasFrameStats ? entry["pixels_per_frame"].get<double>() : -1.0,
+           entry["allocations_per_frame"].get<double>());
+    fflush(stdout);
+    return entry;
+}
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::istringstream stream(list);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+std::vector<int> parseIntList(const std::string& list) {
+    std::vector<int> values;
+    for (const std::string& item : splitList(list)) {
+        values.push_back(std::atoi(item.c_str()));
+    }
+    return values;
+}
+
+bool contains(const std::vector<std::string>& list, const std::string& item) {
+    return std::find(list.begin(), list.end(), item) != list.end();
+}
+
+void printUsage() {
+    printf("Usage: renderer_bench [options]\n"
+           "  --out FILE        JSON results file (default renderer_bench.json)\n"
+           "  --strokes FILE    Also replay recorded strokes: \"x y\" per line, blank line between strokes\n"
+           "  --backends LIST   headless,pool,gdi,overlay (gdi and overlay need Windows and use the real desktop)\n"
+           "  --screens LIST    Simulated screens for headless: 1080p,4K,3x4K\n"
+           "  --points LIST     Synthetic stroke lengths (default 10,100,1000,10000)\n"
+           "  --widths LIST     Line widths (default 1-10)\n"
+           "  --threads LIST    Drawing threads for headless and pool; 0 is the hardware concurrency (default 0)\n"
+           "  --frames N        Timed render() frames per case (default 20)\n");
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--out") {
+            options.outPath = value;
+        } else if (arg == "--strokes") {
+            options.strokesPath = value;
+        } else if (arg == "--backends") {
+            options.backends = splitList(value);
+        } else if (arg == "--screens") {
+            options.screens = splitList(value);
+        } else if (arg == "--points") {
+            options.points = parseIntList(value);
+        } else if (arg == "--widths") {
+            options.lineWidths = parseIntList(value);
+        } else if (arg == "--threads") {
+            options.threads = parseIntList(value);
+        } else if (arg == "--frames") {
+            options.renderFrames = std::max(1, std::atoi(value.c_str()));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Synthetic strokes of every requested length followed by the recorded ones
+std::vector<Stroke> strokesFor(const Screen& screen, const Options& options, const std::vector<Stroke>& recorded) {
+    std::vector<Stroke> strokes;
+    for (int count : options.points) {
+        if (count >= 2) {
+            strokes.push_back(makeSwipe(static_cast<size_t>(count), screen));
+            strokes.push_back(makeScribble(static_cast<size_t>(count), screen));
+        }
+    }
+    strokes.insert(strokes.end(), recorded.begin(), recorded.end());
+    return strokes;
+}
+
+int runBenchmarks(const Options& options) {
+    std::vector<Stroke> recorded;
+    if (!options.strokesPath.empty()) {
+        recorded = loadStrokes(options.strokesPath);
+        if (recorded.empty()) {
+            fprintf(stderr, "No strokes in %s\n", options.strokesPath.c_str());
+            return 1;
+        }
+    }
+
+    nlohmann::json results = nlohmann::json::array();
+    if (contains(options.backends, "headless")) {
+        for (const Screen& screen : SIMULATED_SCREENS) {
+            if (!contains(options.screens, screen.name)) {
+                continue;
+            }
+            for (const Stroke& stroke : strokesFor(screen, options, recorded)) {
+                std::vector<Point> points = toScreen(stroke, screen);
+                for (int lineWidth : options.lineWidths) {
+                    for (int threads : options.threads) {
+                        HeadlessTarget target(screen, lineWidth, threads);
+                        Measurement render = measureRender(target, points, options.renderFrames);
+                        results.push_back(report(
+                                "headless", "render", stroke.name, points.size(), screen, lineWidth, threads, render));
+                        Measurement append = measureAppend(target, points);
+                        results.push_back(report(
+                                "headless", "append", stroke.name, points.size(), screen, lineWidth, threads, append));
+                    }
+                }
+            }
+        }
+    }
+
+    if (contains(options.backends, "pool")) {
+        measurePool(options, results);
+    }
+
+#ifdef _WIN32
+    const Screen desktop = desktopScreen();
+    if (contains(options.backends, "gdi")) {
+        for (const Stroke& stroke : strokesFor(desktop, options, recorded)) {
+            std::vector<Point> points = toScreen(stroke, desktop);
+            for (int lineWidth : options.lineWidths) {
+                GdiTarget target(desktop, lineWidth);
+                Measurement render = measureRender(target, points, options.renderFrames);
+                results.push_back(report("gdi", "render", stroke.name, points.size(), desktop, lineWidth, 0, render));
+                Measurement append = measureAppend(target, points);
+                results.push_back(report("gdi", "append", stroke.name, points.size(), desktop, lineWidth, 0, append));
+                pumpMessages();
+            }
+        }
+    }
+    if (contains(options.backends, "overlay")) {
+        OverlayUI overlay;
+        Settings settings;
+        if (!overlay.initialize(GetModuleHandle(nullptr))) {
+            fprintf(stderr, "Failed to create the overlay window\n");
+            return 1;
+        }
+        // The incremental trail appends each position; without it every position redraws the trajectory
+        const std::pair<RenderMode, const char*> modes[] = {
+                {RenderMode::Gdiplus, "overlay-gdi"},
+                {RenderMode::Memory, "overlay-memory"}};
+        const std::pair<bool, const char*> trails[] = {
+                {true, "update_position"},
+                {false, "update_redraw"}};
+        for (const auto& mode : modes) {
+            settings.setRenderingMode(mode.first);
+            for (const auto& trail : trails) {
+                settings.setIncrementalTrailEnabled(trail.first);
+                for (const Stroke& stroke : strokesFor(desktop, options, recorded)) {
+                    std::vector<Point> points = toScreen(stroke, desktop);
+                    for (int lineWidth : options.lineWidths) {
+                        settings.setGestureLineWidth(lineWidth);
+                        Measurement update = measureOverlay(overlay, settings, points);
+                        results.push_back(report(
+                                mode.second,
+                                trail.second,
+                                stroke.name,
+                                points.size(),
+                                desktop,
+                                lineWidth,
+                                0,
+                                update));
+                    }
+                }
+            }
+        }
+    }
+#endif
+
+    nlohmann::json document = {
+            {"benchmark", "renderer"},
+            {"version", 1},
+            {"hardware_threads", std::thread::hardware_concurrency()},
+            {"results", results},
+    };
+    std::ofstream out(options.outPath);
+    out << document.dump(2) << '\n';
+    if (!out) {
+        fprintf(stderr, "Failed to write %s\n", options.outPath.c_str());
+        return 1;
+    }
+    printf("%zu results written to %s\n", results.size(), options.outPath.c_str());
+    return 0;
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main(int argc, char** argv) {
+    VirtualDesktop::Options options;
+    if (!VirtualDesktop::parseOptions(argc, argv, options)) {
+        VirtualDesktop::printUsage();
+        return 2;
+    }
+    return VirtualDesktop::runBenchmarks(options);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include "VirtualDesktopSwitcher.h"
+#include "Settings.h"
+#include <Windows.h>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Keeps the settings and their config file in sync on a background thread
+ *
+ * Edits of the file are noticed through a directory change notification, or by polling when the directory cannot
+ * be watched, and the file is only reparsed when its time stamp or size differ from the version last read or
+ * written. A valid edit replaces the settings live; an invalid one is ignored. Saves are debounced, so a burst
+ * of changes is written once, off the threads that handle gestures.
+ */
+class VDS_API ConfigWatcher {
+public:
+    using ReloadCallback = std::function<void()>;
+
+    static constexpr DWORD RELOAD_DELAY_MS = 200;    // Quiet time after a change before the file is reparsed
+    static constexpr DWORD SAVE_DELAY_MS = 500;      // Quiet time after the last save request before writing
+    static constexpr DWORD POLL_INTERVAL_MS = 1000;  // Time stamp checks when the directory cannot be watched
+
+    ConfigWatcher() = default;
+    ~ConfigWatcher();
+
+    /**
+     * @brief Starts watching the config file and saving the settings whenever a setter changes them
+     * @param settings Settings loaded from the file; must outlive the watcher
+     * @param filePath Path to the config file
+     * @param onReload Called on the watcher thread after the settings were replaced by an edited file
+     * @return true if the watcher thread was started
+     */
+    bool start(Settings& settings, const std::wstring& filePath, ReloadCallback onReload);
+
+    /**
+     * @brief Stops the watcher thread, first writing any unsaved settings
+     */
+    void stop();
+
+    /**
+     * @brief Asks for the settings to be saved once no further request arrived for SAVE_DELAY_MS
+     */
+    void requestSave();
+
+private:
+    // Identity of a version of the config file
+    struct FileStamp {
+        uint64_t lastWrite = 0;
+        uint64_t size = 0;
+        bool exists = false;
+
+        bool operator==(const FileStamp& other) const {
+            return lastWrite == other.lastWrite && size == other.size && exists == other.exists;
+        }
+    };
+
+    // Disable copy and move
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+    ConfigWatcher(ConfigWatcher&&) = delete;
+    ConfigWatcher& operator=(ConfigWatcher&&) = delete;
+
+    static DWORD WINAPI threadProc(LPVOID param);
+    void run();
+    FileStamp readStamp() const;
+    void reloadIfChanged();
+    void saveIfDirty();
+
+    Settings* m_settings = nullptr;
+    std::wstring m_filePath;
+    ReloadCallback m_onReload;
+    FileStamp m_stamp;  // Version of the file last read or written; watcher thread only after start()
+
+    HANDLE m_thread = nullptr;
+    HANDLE m_wakeEvent = nullptr;              // Auto-reset event signalling a save request or stop()
+    std::atomic<bool> m_saveRequested{false};  // requestSave() was called since the thread last looked
+    std::atomic<bool> m_stopping{false};       // stop() was called
+};
+
+}  // namespace VirtualDesktop
@@ -1,7 +1,11 @@
 #pragma once
 #define _USE_MATH_DEFINES
 #include "VirtualDesktopSwitcher.h"
+#include "StrokeBuffer.h"
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 #include <utility>
 
@@ -56,34 +60,146 @@ struct Point {
     }
 };
 
+// Fixed-capacity structure-of-arrays gesture path, laid out for the vectorized recognizer kernels.
+// Resampled gestures never exceed CAPACITY points, so paths are transformed in place without heap allocation.
+// The layout only uses fixed-width fields so paths can be stored in template library files as they are.
+struct GesturePath {
+    static constexpr size_t CAPACITY = 64;
+
+    alignas(32) double x[CAPACITY];
+    alignas(32) double y[CAPACITY];
+    uint32_t count = 0;
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    void push_back(const Point& p) {
+        x[count] = p.x;
+        y[count] = p.y;
+        ++count;
+    }
+
+    Point operator[](size_t index) const {
+        return Point(x[index], y[index]);
+    }
+
+    Point back() const {
+        return Point(x[count - 1], y[count - 1]);
+    }
+};
+
+class GestureLibrary;
+class IGestureRecognizer;
+
 /**
- * @brief Analyzes mouse gestures to detect swipe directions using $1 Unistroke Recognizer
+ * @brief Analyzes mouse gestures to detect swipe directions with a pluggable recognition engine
  */
 class VDS_API GestureAnalyzer {
 public:
     /**
      * @brief Possible gesture directions
      */
-    enum class Direction { Left, Right, Up, Down, None };
+    enum class Direction : int32_t { Left, Right, Up, Down, None };
+
+    /**
+     * @brief Preprocessed gesture template: normalized path, Protractor vector and the direction it matches
+     */
+    struct GestureTemplate {
+        static constexpr size_t COARSE_BINS = 8;  // Runs of consecutive points summed into the coarse profile
+
+        Direction direction;
+        GesturePath points;
+        GesturePath vector;
+        GesturePath prefilterPoints;  // Low-resolution subset of points matched by the prefilter
+
+        // Rotation-invariant features used to prune templates before the exact distance is computed
+        alignas(32) double radius[GesturePath::CAPACITY];  // Distance of each point from the centroid
+        double coarseRadius[COARSE_BINS];                   // Sums of radius over equal runs of points
+    };
+
+    /**
+     * @brief Running decision on a gesture in progress
+     */
+    struct Decision {
+        Direction direction = Direction::None;
+        double confidence = 0.0;  // Share of the path length travelled along the direction, from 0 to 1
+        double distance = 0.0;    // Displacement along the direction in pixels
+    };
 
     /**
-     * @brief Constructor that initializes the gesture templates
+     * @brief Running motion state of the gesture in progress, from the sample timestamps
+     */
+    struct Kinematics {
+        // Smoothed velocity in pixels per millisecond
+        double velocityX = 0.0;
+        double velocityY = 0.0;
+        double acceleration = 0.0;  // Change of the smoothed speed in pixels per millisecond squared
+        double peakSpeed = 0.0;     // Highest smoothed speed within the flick window
+        // Smoothed velocity when the peak speed was reached
+        double peakVelocityX = 0.0;
+        double peakVelocityY = 0.0;
+    };
+
+    /**
+     * @brief Constructor; starts with the "simple" recognition engine
      */
     GestureAnalyzer();
+    ~GestureAnalyzer();
 
     /**
      * @brief Adds a new mouse position to the gesture analysis
      * @param x The x coordinate of mouse position
      * @param y The y coordinate of mouse position
+     * @param time Timestamp of the position in milliseconds, such as MSLLHOOKSTRUCT::time; may wrap around
      */
-    void addPosition(int32_t x, int32_t y);
+    void addPosition(int32_t x, int32_t y, uint32_t time);
 
     /**
      * @brief Analyzes the collected positions to detect gesture direction
-     * @return Detected gesture direction
+     * @return Detected gesture direction; strokes the engine rejects can still be recognized as a flick
      */
     Direction analyzeGesture() const;
 
+    /**
+     * @brief Detects a short, fast flick from the peak velocity early in the motion
+     * @return The flick direction, or None if the stroke did not start with a flick
+     */
+    Direction detectFlick() const;
+
+    /**
+     * @brief Returns the running velocity and acceleration of the gesture in progress
+     */
+    const Kinematics& kinematics() const;
+
+    /**
+     * @brief Sets how readily short, fast strokes are recognized as flicks
+     * @param sensitivity 1 (least sensitive) to 10 (most sensitive)
+     */
+    void setSensitivity(int sensitivity);
+
+    /**
+     * @brief Recognizes the positions collected so far and rates how firmly they express the direction
+     * @return The current decision; confidence and distance are 0 if no direction is recognized
+     */
+    Decision currentDecision() const;
+
+    /**
+     * @brief Decides a gesture before it is finished, once it is confident and long enough
+     * @param minConfidence Confidence the current decision must reach
+     * @param minDistance Distance in pixels the current decision must reach
+     * @return The recognized direction if both thresholds are reached, None otherwise
+     */
+    Direction analyzeEarly(double minConfidence, double minDistance) const;
+
     /**
      * @brief Clears all collected positions
      */
@@ -96,47 +212,62 @@ public:
      */
     bool isGestureInProgress() const;
 
-private:
-    // $1 Unistroke Recognizer constants
-    static constexpr int NUM_POINTS = 64;           // Number of points to resample each gesture to
-    static constexpr double ANGLE_RANGE = 45.0;     // Angle range for rotation in degrees
-    static constexpr double ANGLE_PRECISION = 2.0;  // Angle precision for search in degrees
-    static constexpr double DIAGONAL = 250.0;       // Square root of 250^2 + 250^2 (bounding box size)
-    static constexpr double HALF_DIAGONAL = 125.0;  // Half of the diagonal
-    static constexpr double PHI = 0.618033988;      // Golden ratio - 1 (0.5 * (-1.0 + std::sqrt(5.0)) calculated)
-
-    std::vector<std::pair<int32_t, int32_t>> m_rawPositions;
-    std::vector<Point> m_processedGesture;
-    static std::vector<std::vector<Point>> s_templates;  // Predefined gesture templates
-    mutable bool m_useUnistroke;                         // Flag to determine which algorithm to use
-
-    // $1 Unistroke Recognizer methods
-    std::vector<Point> resample(const std::vector<Point>& points, int n) const;
-    double indicativeAngle(const std::vector<Point>& points) const;
-    std::vector<Point> rotateBy(const std::vector<Point>& points, double radians) const;
-    std::vector<Point> scaleTo(const std::vector<Point>& points, double size) const;
-    std::vector<Point> translateTo(const std::vector<Point>& points, Point origin) const;
-    double distanceAtAngle(const std::vector<Point>& points, const std::vector<Point>& templatePoints, double radians)
-            const;
-    double distanceAtBestAngle(const std::vector<Point>& points, const std::vector<Point>& templatePoints) const;
-    double pathDistance(const std::vector<Point>& pts1, const std::vector<Point>& pts2) const;
-    Point centroid(const std::vector<Point>& points) const;
-    double pathLength(const std::vector<Point>& points) const;
-    double distance(const Point& p1, const Point& p2) const;
-
-    // Algorithm methods
-    Direction analyzeGestureSimple() const;
-    Direction analyzeGestureUnistroke() const;
-
-    // Initialize predefined gesture templates
-    void initializeTemplates();
+    /**
+     * @brief Bounds the positions stored for a stroke; clears the collected positions
+     * @param capacity Max number of stored positions; longer strokes are thinned out evenly
+     * @param radius Positions closer than this many pixels to the previous stored one only move the stroke end
+     */
+    void setStrokeLimits(size_t capacity, int32_t radius);
+
+    /**
+     * @brief Selects the gesture recognition engine
+     * @param name Name of a registered engine, see recognizerNames()
+     * @return true if the engine was selected, false if no engine is registered under that name
+     */
+    bool setRecognizer(const std::string& name);
+
+    /**
+     * @brief Sets user-recorded templates matched in addition to the built-in ones
+     * @param library Template library that must outlive the analyzer, or nullptr for built-in templates only
+     */
+    void setTemplateLibrary(const GestureLibrary* library);
 
-public:
     /**
-     * @brief Sets the gesture recognition algorithm to use
-     * @param useUnistroke true to use $1 Unistroke Recognizer, false to use simple algorithm
+     * @brief Preprocesses the collected positions into a template for the given direction
+     * @param direction Direction the recorded stroke stands for
+     * @param result Receives the normalized template
+     * @return true if enough positions were collected to build a template
      */
-    void setAlgorithm(bool useUnistroke);
+    bool createTemplate(Direction direction, GestureTemplate& result) const;
+
+private:
+    // Flick detection constants
+    static constexpr uint32_t FLICK_WINDOW = 60;        // Milliseconds from the start of motion searched for the peak
+    static constexpr double FLICK_MIN_DISTANCE = 20.0;  // Min displacement of a flick in pixels
+    static constexpr double FLICK_AXIS_RATIO = 2.0;     // Min ratio of the major to the minor velocity component
+    static constexpr uint32_t VELOCITY_INTERVAL = 8;    // Min milliseconds between samples a velocity is measured on
+    static constexpr double VELOCITY_SMOOTHING = 0.5;   // Weight of the newest velocity in the running average
+
+    // Disable copy and move
+    GestureAnalyzer(const GestureAnalyzer&) = delete;
+    GestureAnalyzer& operator=(const GestureAnalyzer&) = delete;
+
+    void updateKinematics(int32_t x, int32_t y, uint32_t time);
+
+    StrokeBuffer<std::pair<int32_t, int32_t>> m_stroke;  // Decimated positions of the current stroke
+    double m_pathLength;                                 // Length of the polyline through all added positions
+    std::unique_ptr<IGestureRecognizer> m_recognizer;    // Selected recognition engine
+    const GestureLibrary* m_library;                     // User-recorded templates, if any
+
+    // Motion state; velocities are measured between samples at least VELOCITY_INTERVAL apart
+    Kinematics m_kinematics;
+    int32_t m_sampleX;       // Position of the last sample a velocity was measured at
+    int32_t m_sampleY;
+    uint32_t m_sampleTime;   // Timestamp of that sample
+    uint32_t m_motionStart;  // Timestamp of the first position that moved away from the start
+    bool m_moving;           // The stroke has moved away from its first position
+    bool m_hasVelocity;      // The velocity has been measured at least once
+    double m_flickSpeed;     // Min peak speed of a flick in pixels per millisecond, from the sensitivity
 };
 
 }  // namespace VirtualDesktop
\ No newline at end of file
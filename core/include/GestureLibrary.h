@@ -0,0 +1,81 @@
+#pragma once
+#include "VirtualDesktopSwitcher.h"
+#include "GestureAnalyzer.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief User-recorded gesture templates persisted in a memory-mapped binary file
+ *
+ * The file is a small header followed by preprocessed GestureAnalyzer::GestureTemplate records laid out
+ * exactly as they are in memory. Loading maps the file read-only and hands out the records in place, so
+ * there is nothing to parse and the pages are only brought in when templates are matched.
+ */
+class VDS_API GestureLibrary {
+public:
+    // Version of the file layout; files with any other version are ignored
+    static constexpr uint32_t FORMAT_VERSION = 3;
+
+    GestureLibrary() = default;
+    ~GestureLibrary();
+
+    /**
+     * @brief Maps a template library file
+     * @param filePath Path to the library file; remembered for add() even if it does not exist yet
+     * @return true if the file was mapped, false if it is missing or not a valid library
+     */
+    bool load(const std::wstring& filePath);
+
+    /**
+     * @brief Appends a template to the library file and maps the updated file
+     * @param gestureTemplate Template to store
+     * @return true if the template was written
+     */
+    bool add(const GestureAnalyzer::GestureTemplate& gestureTemplate);
+
+    /**
+     * @brief Uses templates held in memory instead of a library file, such as generated ones in benchmarks
+     * @param templates Templates that must stay valid until the next load(), add(), assign() or close(); not copied
+     * @param count Number of templates
+     */
+    void assign(const GestureAnalyzer::GestureTemplate* templates, size_t count);
+
+    /**
+     * @brief Unmaps the library file
+     */
+    void close();
+
+    /**
+     * @brief Returns the mapped templates; valid until the next load(), add() or close()
+     */
+    const GestureAnalyzer::GestureTemplate* templates() const {
+        return m_templates;
+    }
+
+    /**
+     * @brief Returns the number of mapped templates
+     */
+    size_t size() const {
+        return m_count;
+    }
+
+private:
+    // Disable copy and move
+    GestureLibrary(const GestureLibrary&) = delete;
+    GestureLibrary& operator=(const GestureLibrary&) = delete;
+    GestureLibrary(GestureLibrary&&) = delete;
+    GestureLibrary& operator=(GestureLibrary&&) = delete;
+
+    std::wstring m_filePath;
+    // Win32 handles, kept as void* so the recognizers that read the templates build without Windows.h
+    void* m_file = nullptr;  // Null while no file is open
+    void* m_mapping = nullptr;
+    const void* m_view = nullptr;
+    const GestureAnalyzer::GestureTemplate* m_templates = nullptr;
+    size_t m_count = 0;
+};
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,67 @@
+#pragma once
+#include "VirtualDesktopSwitcher.h"
+#include "GestureAnalyzer.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace VirtualDesktop {
+
+class GestureLibrary;
+
+/**
+ * @brief Interface of gesture recognition engines
+ *
+ * GestureAnalyzer feeds every engine the same stream of de-duplicated positions: addPoint() is called for
+ * each new position and recognize() receives the stored stroke, so engines can work incrementally or in batch.
+ * The stored stroke may be decimated, but it always starts and ends at the first and latest positions.
+ */
+class IGestureRecognizer {
+public:
+    using Direction = GestureAnalyzer::Direction;
+    using Positions = std::vector<std::pair<int32_t, int32_t>>;
+
+    virtual ~IGestureRecognizer() = default;
+
+    // Starts a new stroke
+    virtual void reset() = 0;
+
+    // Receives the next position of the current stroke
+    virtual void addPoint(int32_t x, int32_t y) = 0;
+
+    // Classifies the current stroke; positions holds the stored, possibly decimated, points since reset()
+    virtual Direction recognize(const Positions& positions) const = 0;
+
+    // Template-matching engines also match the user-recorded templates; other engines ignore them
+    virtual void setTemplateLibrary(const GestureLibrary* /*library*/) {
+    }
+};
+
+using RecognizerFactory = std::function<std::unique_ptr<IGestureRecognizer>()>;
+
+/**
+ * @brief Registers a recognition engine under a name that can be selected in the settings
+ *
+ * Safe to call from any thread, including while the hook worker creates engines.
+ *
+ * @param name Engine name; an engine already registered under that name is replaced
+ * @param factory Function creating a new instance of the engine
+ */
+VDS_API void registerRecognizer(const std::string& name, RecognizerFactory factory);
+
+/**
+ * @brief Creates a registered recognition engine
+ * @param name Engine name
+ * @return The new engine, or nullptr if no engine is registered under that name
+ */
+VDS_API std::unique_ptr<IGestureRecognizer> createRecognizer(const std::string& name);
+
+/**
+ * @brief Returns the names of all registered recognition engines
+ */
+VDS_API std::vector<std::string> recognizerNames();
+
+}  // namespace VirtualDesktop
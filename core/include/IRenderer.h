@@ -1,6 +1,7 @@
 #pragma once
 #include "Settings.h"
 #include <Windows.h>
+#include <cstddef>
 #include <vector>
 #include <string>
 
@@ -14,7 +15,16 @@ public:
     virtual bool initialize(HWND hwndParent) = 0;
     virtual void resizeForMonitors() = 0;
     virtual void render(const std::vector<POINT>& points) = 0;
+    // Extends the trail drawn by render() and earlier append() calls to a new point, leaving the rest untouched
+    virtual void append(const POINT& point) = 0;
     virtual void clear() = 0;
+
+    // Allocates the drawing surface if it is not allocated yet; called when a gesture starts
+    virtual bool prepare() = 0;
+    // Releases the drawing surface until the next prepare() or render()
+    virtual void trim() = 0;
+    // Bytes held by the drawing surface
+    virtual size_t surfaceBytes() const = 0;
 };
 
 std::unique_ptr<IRenderer> createRendererByMode(RenderMode mode);
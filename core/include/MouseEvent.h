@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Compact copy of a low-level mouse hook event, passed from the hook to the worker thread
+ */
+struct MouseEvent {
+    uint32_t message;    // Mouse message, e.g. WM_MOUSEMOVE or WM_XBUTTONDOWN
+    int32_t x;           // Cursor position in per-monitor-aware screen coordinates
+    int32_t y;
+    uint32_t mouseData;  // MSLLHOOKSTRUCT::mouseData; the high word holds the X button or wheel delta
+    uint32_t time;       // Event time stamp in milliseconds
+};
+
+static_assert(std::is_trivially_copyable<MouseEvent>::value, "MouseEvent is copied through a lock-free queue");
+static_assert(sizeof(MouseEvent) == 20, "MouseEvent is kept compact so the queue stays cache-friendly");
+
+}  // namespace VirtualDesktop
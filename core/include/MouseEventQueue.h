@@ -0,0 +1,126 @@
+#pragma once
+#include "MouseEvent.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Queue of mouse events from the hook thread to the worker thread that never loses half of a click
+ *
+ * A gesture is framed by the press and release of the trigger button, so losing either one leaves the
+ * worker drawing a gesture that never ends or ending one that never started. Moves and other events may be
+ * dropped when the worker falls behind; the trigger button may not:
+ * - other events leave TRIGGER_HEADROOM slots free, so presses and releases still fit when they are refused
+ * - a press that does not fit is dropped together with its release, as a whole click
+ * - a release that does not fit is set aside and delivered once the queued events are drained; until then
+ *   every other event is refused, so nothing overtakes it
+ *
+ * Like SpscQueue, it is used by exactly one producer thread and one consumer thread and never blocks.
+ */
+class MouseEventQueue {
+public:
+    static constexpr size_t CAPACITY = 1024;        // Events buffered for the worker, about a second of input
+    static constexpr size_t TRIGGER_HEADROOM = 64;  // Slots only trigger presses and releases may take
+
+    // Each queued event travels with its MouseHook::EventMask bit, so the worker need not classify it again
+    struct Item {
+        MouseEvent event;
+        uint32_t kind;
+    };
+
+    MouseEventQueue() = default;
+    MouseEventQueue(const MouseEventQueue&) = delete;
+    MouseEventQueue& operator=(const MouseEventQueue&) = delete;
+
+    /**
+     * @brief Appends an event other than a trigger press or release; producer thread only
+     * @return false if the event was dropped
+     */
+    bool pushEvent(const Item& item) {
+        if (m_releasePending.load(std::memory_order_acquire) || !m_queue.push(item, TRIGGER_HEADROOM)) {
+            m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Appends a trigger press; producer thread only
+     * @return false if the press was dropped, in which case its release is dropped too and the caller must
+     *         not start a gesture
+     */
+    bool pushPress(const Item& item) {
+        if (m_releasePending.load(std::memory_order_acquire) || !m_queue.push(item)) {
+            m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            m_pressDropped = true;
+            return false;
+        }
+        m_pressDropped = false;
+        return true;
+    }
+
+    /**
+     * @brief Appends a trigger release, or sets it aside if the queue is full; producer thread only
+     * @return false if the release was dropped because its press was
+     */
+    bool pushRelease(const Item& item) {
+        if (m_pressDropped) {
+            m_pressDropped = false;
+            m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // A pending release belongs to an earlier press, and no press is queued after it, so one slot is enough
+        if (m_releasePending.load(std::memory_order_acquire)) {
+            m_droppedEvents.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!m_queue.push(item)) {
+            m_pendingRelease = item;
+            m_releasePending.store(true, std::memory_order_release);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest event, the set-aside release once the others are drained; consumer thread only
+     * @return false if there are no events
+     */
+    bool tryPop(Item& item) {
+        // Check for the set-aside release first: everything queued before it is then visible, and nothing is
+        // queued after it, so it is due once the queue is empty
+        const bool releasePending = m_releasePending.load(std::memory_order_acquire);
+        if (m_queue.tryPop(item)) {
+            return true;
+        }
+        if (!releasePending) {
+            return false;
+        }
+        item = m_pendingRelease;
+        m_releasePending.store(false, std::memory_order_release);
+        return true;
+    }
+
+    // Whether the queue looked empty when checked; exact only on the consumer thread
+    bool empty() const {
+        return m_queue.empty() && !m_releasePending.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Returns the number of events dropped since the last call and resets it; any thread
+     */
+    uint32_t takeDroppedEvents() {
+        return m_droppedEvents.exchange(0);
+    }
+
+private:
+    SpscQueue<Item, CAPACITY> m_queue;
+    Item m_pendingRelease{};                    // Release waiting for the queue to drain, owned by the flag below
+    std::atomic<bool> m_releasePending{false};  // Set by the producer, cleared by the consumer once delivered
+    bool m_pressDropped = false;                // Producer only: the last trigger press was dropped
+    std::atomic<uint32_t> m_droppedEvents{0};   // Events lost because the queue was full
+};
+
+}  // namespace VirtualDesktop
@@ -1,34 +1,126 @@
 #pragma once
 #include "VirtualDesktopSwitcher.h"
+#include "MouseEvent.h"
+#include "MouseEventQueue.h"
 #include <Windows.h>
+#include <atomic>
+#include <cstdint>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace VirtualDesktop {
 
 /**
- * @brief Captures and processes mouse events using Windows hook
+ * @brief Captures mouse events using a Windows low-level hook and processes them on a worker thread
+ *
+ * The hook procedure only copies each event into a lock-free queue and returns, so slow callbacks never
+ * delay the mouse input of the whole system or get the hook dropped by Windows. Callbacks run on the
+ * worker thread, in event order.
+ *
+ * Every callback subscribes to a mask of event kinds, and events nobody subscribed to are not queued at all.
+ * The hook arms itself when the trigger button is pressed and disarms when it is released, so the mouse moves
+ * outside a gesture, by far the most frequent events, return from the hook after a couple of branches.
  */
 class VDS_API MouseHook {
 public:
-    using EventCallback = std::function<void(int, WPARAM, LPARAM)>;
+    using EventCallback = std::function<void(const MouseEvent&)>;
+    using CallbackId = uint32_t;
+
+    /**
+     * @brief Kinds of mouse events a callback can subscribe to
+     */
+    enum EventMask : uint32_t {
+        TriggerButton = 1u << 0,  // Press and release of the trigger button, which arm and disarm the hook
+        OtherButtons = 1u << 1,   // Press and release of any other button
+        ArmedMove = 1u << 2,      // Moves while the trigger button is held
+        IdleMove = 1u << 3,       // Moves while the trigger button is not held
+        Wheel = 1u << 4,          // Vertical and horizontal wheel rotation
+        AllEvents = (1u << 5) - 1
+    };
 
     static MouseHook& getInstance();
 
+    /**
+     * @brief Starts the worker thread and installs the hook on the calling thread, which must pump messages
+     * @return true if the hook is installed
+     */
     bool initialize();
+
+    /**
+     * @brief Removes the hook, lets the worker finish the queued events and stops it; call from the hook thread
+     */
     void shutdown();
 
-    void addCallback(const EventCallback& callback);
+    /**
+     * @brief Sets the button whose press arms the hook; safe to call from any thread
+     *
+     * A gesture in progress is not affected: the hook takes the new button at the first button event after the
+     * current trigger button is released, so calling this again with the same button changes nothing.
+     *
+     * @param downMessage WM_LBUTTONDOWN, WM_RBUTTONDOWN or WM_XBUTTONDOWN, or 0 to never arm
+     * @param xButton XBUTTON1 or XBUTTON2 when downMessage is WM_XBUTTONDOWN
+     */
+    void setTrigger(uint32_t downMessage, uint16_t xButton = 0);
+
+    /**
+     * @brief Registers a callback; safe to call from any thread, including from a callback
+     * @param callback Function called on the worker thread
+     * @param mask EventMask bits of the events to receive
+     * @return Id to pass to removeCallback()
+     */
+    CallbackId addCallback(const EventCallback& callback, uint32_t mask = AllEvents);
+
+    /**
+     * @brief Unregisters a callback; safe to call from any thread, including from a callback
+     *
+     * Once this returns, the callback is not called for any event that is dispatched afterwards.
+     */
+    void removeCallback(CallbackId id);
     void removeCallbacks();
 
 private:
+    struct Subscription {
+        CallbackId id;
+        uint32_t mask;
+        EventCallback callback;
+    };
+    using CallbackList = std::vector<Subscription>;
+
     MouseHook() = default;
-    ~MouseHook() = default;
+    ~MouseHook();
 
     static LRESULT CALLBACK hookCallback(int nCode, WPARAM wParam, LPARAM lParam);
+    static DWORD WINAPI workerProc(LPVOID param);
+
+    uint32_t classifyButton(uint32_t message, uint32_t mouseData);
+    void enqueue(const MouseEvent& event, uint32_t kind);
+    void workerLoop();
+
+    // Replaces the callback list; callers hold m_callbacksMutex
+    void publishCallbacks(std::shared_ptr<const CallbackList> callbacks);
 
     HHOOK m_hook = nullptr;
-    std::vector<EventCallback> m_callbacks;
+
+    // Copy-on-write callback list: writers copy, edit and publish a new list under the mutex while the worker
+    // keeps dispatching from the list it loaded, which stays alive until the worker drops it
+    std::shared_ptr<const CallbackList> m_callbacks;
+    std::mutex m_callbacksMutex;
+    CallbackId m_nextCallbackId = 1;
+
+    // Read by the hook procedure on every event
+    std::atomic<uint32_t> m_subscribedMask{0};  // Union of the masks of all callbacks
+    std::atomic<uint32_t> m_nextTrigger{0};     // Set by setTrigger(), taken by the hook thread between gestures
+    std::atomic<bool> m_armed{false};           // The trigger button is held
+    // Hook thread only: trigger down message in the low word, X button in the high word
+    uint32_t m_trigger = 0;
+
+    MouseEventQueue m_queue;                // Hook thread to worker thread; never drops trigger releases
+    HANDLE m_worker = nullptr;              // Thread running the callbacks
+    HANDLE m_wakeEvent = nullptr;           // Auto-reset event set when the worker waits for events
+    std::atomic<bool> m_running{false};     // Cleared to stop the worker once the queue is drained
+    std::atomic<bool> m_workerIdle{false};  // The worker found the queue empty and is about to wait
 };
 
-}  // namespace VirtualDesktop
\ No newline at end of file
+}  // namespace VirtualDesktop
@@ -1,7 +1,11 @@
 ﻿#pragma once
 #include "VirtualDesktopSwitcher.h"
 #include "Settings.h"
+#include "StrokeBuffer.h"
 #include <Windows.h>
+#include <atomic>
+#include <cstddef>
+#include <mutex>
 #include <vector>
 #include <memory>
 
@@ -10,6 +14,14 @@ namespace VirtualDesktop {
 class IRenderer;
 /**
  * @brief Renders overlay UI for gesture visualization
+ *
+ * show(), hide() and updatePosition() run on the mouse hook worker thread, while the window belongs to the
+ * UI thread. The renderer's surface is allocated while a gesture is drawn and trimmed by the UI thread once the
+ * overlay has been hidden for the configured delay; the UI thread only ever try-locks the renderer, because the
+ * worker may be waiting on it from inside a window call.
+ *
+ * With the incremental trail enabled, updatePosition() only hands the new position to the renderer, which draws
+ * the one segment it adds. The stored trajectory is then only redrawn as a whole after a display change.
  */
 class VDS_API OverlayUI {
 public:
@@ -56,17 +68,34 @@ public:
      */
     void setSettings(const Settings& settings);
 
+    /**
+     * @brief Returns the memory held by the overlay surface in bytes, 0 while it is trimmed
+     */
+    size_t surfaceBytes() const;
+
 private:
+    static constexpr UINT WM_OVERLAY_HIDDEN = WM_APP + 1;  // Posted by hide() to start the trim timer
+    static constexpr UINT_PTR TRIM_TIMER_ID = 1;
+
     static LRESULT CALLBACK windowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam);
     void switchRenderer();
+    void trimIfIdle();
 
 private:
     std::unique_ptr<IRenderer> m_renderer;  // Active renderer created by factory
-    std::vector<POINT> m_trajectoryPoints;
-    std::vector<POINT> m_smoothedPoints;  // For storing smoothed trajectory
+    StrokeBuffer<POINT> m_trajectoryPoints;  // Bounded, decimated trail positions
+    std::vector<POINT> m_smoothedPoints;     // For storing smoothed trajectory
     HWND m_hWnd = nullptr;
     const Settings* m_settings;  // Pointer to settings instead of copy
 
+    std::mutex m_rendererMutex;                // Guards m_renderer and m_visible
+    bool m_visible = false;                    // Between show() and hide()
+    std::atomic<bool> m_resizePending{false};  // The display changed while the worker held the renderer
+    std::atomic<UINT> m_trimDelayMs{30000};    // Idle time before the surface is released; 0 keeps it
+    std::atomic<size_t> m_surfaceBytes{0};     // Last known size of the renderer surface
+    std::atomic<bool> m_redrawPending{false};  // The renderer dropped the trail, e.g. on a display change
+    bool m_incrementalTrail = true;            // Append each position instead of redrawing the trajectory
+
     // Smooth the trajectory points for less jittery display
     void smoothTrajectory();
 };
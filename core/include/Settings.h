@@ -1,14 +1,21 @@
 ﻿#pragma once
 #include "VirtualDesktopSwitcher.h"
 #include "nlohmann/json.hpp"
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
 namespace VirtualDesktop {
 
 // 定义鼠标切换键枚举类型
 enum class MouseButton { None, Left, Right, X1, X2 };
 
-enum class RenderMode { Direct2D, Gdiplus };
+// Memory draws into a framebuffer instead of the overlay window, for measuring and testing
+enum class RenderMode { Direct2D, Gdiplus, Memory };
 
 // mousebutton to string
 std::string mouseButtonToString(MouseButton button);
@@ -16,8 +23,41 @@ std::string mouseButtonToString(MouseButton button);
 // string to mousebutton
 MouseButton stringToMouseButton(const std::string& button);
 
+/**
+ * @brief Typed copy of the settings, compiled from the JSON configuration whenever it changes
+ *
+ * Values are parsed once, so reading one is a plain load. Snapshots are immutable and compact enough to share a
+ * cache line. The string-valued recognizer name is not included; it is only read when the engine is chosen.
+ */
+struct SettingsSnapshot {
+    double earlyCommitConfidence;    // Min confidence of an early gesture decision
+    uint32_t overlayColor;           // Trail color as 0xAARRGGBB, parsed from "#RRGGBBAA"
+    int32_t sensitivity;             // Gesture sensitivity, 1 to 10
+    int32_t lineWidth;               // Trail width in pixels
+    int32_t earlyCommitDistance;     // Min stroke length of an early gesture decision in pixels
+    int32_t strokeCapacity;          // Max number of stored stroke positions
+    int32_t strokeDecimationRadius;  // Min distance between stored stroke positions in pixels
+    int32_t transparency;            // Overlay transparency, 0 to 100
+    int32_t surfaceTrimDelay;        // Seconds the overlay stays hidden before its surface is released; 0 never
+    MouseButton triggerButton;
+    RenderMode renderingMode;
+    bool autoStart;
+    bool trayIcon;
+    bool earlyCommit;
+    bool incrementalTrail;  // Draw only the newest trail segment on each mouse move
+    bool desktopCycle;
+    bool desktopPreview;
+    bool switchAnimation;
+};
+
+static_assert(sizeof(SettingsSnapshot) <= 64, "SettingsSnapshot should fit in a cache line");
+
 /**
  * @brief Manages application configuration
+ *
+ * The typed getters read the current SettingsSnapshot, which is swapped atomically by load() and by every
+ * setter, so they are safe to call from any thread and never wait for a writer. Setters and the
+ * string-valued getters are meant for the UI thread.
  */
 class VDS_API Settings {
 public:
@@ -30,11 +70,46 @@ public:
 
     /**
      * @brief Saves settings to config file
+     *
+     * The file is written under a temporary name and renamed over the config, so it is never left truncated.
+     *
      * @param filePath Path to config file
      * @return true if saved successfully
      */
     bool save(const std::wstring& filePath) const;
 
+    /**
+     * @brief Replaces the settings with a config file that changed on disk
+     *
+     * Unlike load(), an unreadable, malformed or mistyped file leaves the current settings untouched.
+     *
+     * @param filePath Path to config file
+     * @return true if the file was valid and its settings are now current
+     */
+    bool reload(const std::wstring& filePath);
+
+    /**
+     * @brief Sets the function told about every setter call, such as one that schedules a save
+     * @param onChange Called on the thread of the setter with the settings locked, so it must not call back
+     *                 into them; empty to stop notifying
+     */
+    void setChangeCallback(std::function<void()> onChange);
+
+    /**
+     * @brief Whether a setter changed the settings since they were last loaded or saved
+     */
+    bool isDirty() const {
+        return m_dirty.load();
+    }
+
+    /**
+     * @brief Returns the current typed settings without locking
+     * @return Snapshot that stays valid for the lifetime of this object; a later change publishes a new one
+     */
+    const SettingsSnapshot& snapshot() const {
+        return *m_snapshot.load(std::memory_order_acquire);
+    }
+
     // Basic settings
     bool isAutoStartEnabled() const;
     void setAutoStartEnabled(bool enabled);
@@ -50,12 +125,28 @@ public:
     void setOverlayColor(const std::string& color);
     int getGestureLineWidth() const;
     void setGestureLineWidth(int value);
+    std::string getRecognizer() const;
+    void setRecognizer(const std::string& name);
+    bool isEarlyCommitEnabled() const;
+    void setEarlyCommitEnabled(bool enabled);
+    double getEarlyCommitConfidence() const;
+    void setEarlyCommitConfidence(double value);
+    int getEarlyCommitDistance() const;
+    void setEarlyCommitDistance(int value);
+    int getStrokeCapacity() const;
+    void setStrokeCapacity(int value);
+    int getStrokeDecimationRadius() const;
+    void setStrokeDecimationRadius(int value);
 
     // Rendering settings
     RenderMode getRenderingMode() const;
     void setRenderingMode(RenderMode mode);
     int getTransparency() const;
     void setTransparency(int value);
+    int getSurfaceTrimDelay() const;
+    void setSurfaceTrimDelay(int seconds);
+    bool isIncrementalTrailEnabled() const;
+    void setIncrementalTrailEnabled(bool enabled);
 
     // Behavior settings
     bool isDesktopCycleEnabled() const;
@@ -65,7 +156,7 @@ public:
     bool isSwitchAnimationEnabled() const;
     void setSwitchAnimationEnabled(bool enabled);
 
-    Settings() = default;
+    Settings();
     ~Settings() = default;
 
 private:
@@ -75,7 +166,44 @@ private:
     Settings(Settings&&) = delete;
     Settings& operator=(Settings&&) = delete;
 
+    // Valid ranges of the numeric settings, enforced by the setters and on values read from the config file
+    static constexpr int MIN_SENSITIVITY = 1;
+    static constexpr int MAX_SENSITIVITY = 10;
+    static constexpr int MIN_LINE_WIDTH = 1;
+    static constexpr int MAX_LINE_WIDTH = 10;
+    static constexpr double MIN_EARLY_COMMIT_CONFIDENCE = 0.0;
+    static constexpr double MAX_EARLY_COMMIT_CONFIDENCE = 1.0;
+    static constexpr int MIN_EARLY_COMMIT_DISTANCE = 50;
+    static constexpr int MAX_EARLY_COMMIT_DISTANCE = 2000;
+    static constexpr int MIN_STROKE_CAPACITY = 64;
+    static constexpr int MAX_STROKE_CAPACITY = 65536;
+    static constexpr int MIN_STROKE_DECIMATION_RADIUS = 1;
+    static constexpr int MAX_STROKE_DECIMATION_RADIUS = 32;
+    static constexpr int MIN_TRANSPARENCY = 0;
+    static constexpr int MAX_TRANSPARENCY = 100;
+    static constexpr int MIN_SURFACE_TRIM_DELAY = 0;
+    static constexpr int MAX_SURFACE_TRIM_DELAY = 3600;
+
+    // Compiles a configuration into a snapshot, clamping numbers to their ranges; throws if a value has the
+    // wrong type
+    static std::unique_ptr<const SettingsSnapshot> compile(const nlohmann::json& config);
+
+    // Makes a snapshot current; callers hold m_writeMutex
+    void publish(std::unique_ptr<const SettingsSnapshot> snapshot);
+
+    // Publishes m_config after a setter changed it, marks the settings dirty and calls the change callback;
+    // callers hold m_writeMutex
+    void update();
+
     nlohmann::json m_config;
+    mutable std::mutex m_writeMutex;           // Serializes writers of m_config and its string readers
+    mutable std::atomic<bool> m_dirty{false};  // Changed since the last load or save
+    std::function<void()> m_onChange;          // Called by every setter; guarded by m_writeMutex
+
+    // Readers may still hold any published snapshot, so all of them are kept until the settings are destroyed.
+    // One is published per load, reload or setter call, which only happen on user action, at 64 bytes each.
+    std::vector<std::unique_ptr<const SettingsSnapshot>> m_snapshots;
+    std::atomic<const SettingsSnapshot*> m_snapshot{nullptr};  // Current snapshot, the last of m_snapshots
 };
 
 }  // namespace VirtualDesktop
\ No newline at end of file
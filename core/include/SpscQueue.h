@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Wait-free bounded queue for exactly one producer thread and one consumer thread
+ *
+ * push() and tryPop() never block, allocate or take a lock: each side owns one index, publishes it with a
+ * release store and only reloads the other side's index when its cached copy says the ring is full or empty.
+ * The two indices and the slots live on separate cache lines, so the threads do not invalidate each other's
+ * line on every operation.
+ *
+ * @tparam T Trivially copyable item type
+ * @tparam Capacity Number of slots, a power of two
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value, "Items are copied into the slots as plain data");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    /**
+     * @brief Appends an item; producer thread only
+     * @return false if the queue is full and the item was not added
+     */
+    bool push(const T& item) {
+        return push(item, 0);
+    }
+
+    /**
+     * @brief Appends an item only if more than headroom slots are free; producer thread only
+     *
+     * Lets the producer keep the last slots for items that must not be lost, by pushing everything else with
+     * a headroom.
+     *
+     * @param headroom Slots that must stay free after the item is added, below Capacity
+     * @return false if the queue is too full and the item was not added
+     */
+    bool push(const T& item, size_t headroom) {
+        size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead >= Capacity - headroom) {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead >= Capacity - headroom) {
+                return false;
+            }
+        }
+        m_slots[tail & MASK] = item;
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Removes the oldest item; consumer thread only
+     * @return false if the queue is empty
+     */
+    bool tryPop(T& item) {
+        size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail) {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail) {
+                return false;
+            }
+        }
+        item = m_slots[head & MASK];
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Whether the queue looked empty when checked; exact only on the consumer thread
+    bool empty() const {
+        return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire);
+    }
+
+    static constexpr size_t capacity() {
+        return Capacity;
+    }
+
+private:
+    static constexpr size_t MASK = Capacity - 1;
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Consumer side; padded rather than over-aligned so the queue can live in any object
+    std::atomic<size_t> m_head{0};
+    size_t m_cachedTail = 0;  // Last tail seen by the consumer
+    char m_consumerPadding[CACHE_LINE];
+
+    // Producer side
+    std::atomic<size_t> m_tail{0};
+    size_t m_cachedHead = 0;  // Last head seen by the producer
+    char m_producerPadding[CACHE_LINE];
+
+    T m_slots[Capacity];
+};
+
+}  // namespace VirtualDesktop
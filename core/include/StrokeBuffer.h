@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Fixed-capacity storage for the positions of a stroke with online spatial decimation
+ *
+ * A position closer than the decimation radius to the last kept one only replaces the provisional tail, so
+ * the stroke always ends at the latest position but slow or high-rate input adds no points. When the buffer
+ * is full, every other point is dropped and the radius doubles, which keeps memory and the work per position
+ * bounded however long the stroke gets while the first and latest positions are always kept.
+ *
+ * @tparam T Point type constructible as T{x, y} with x and y members or first and second members
+ */
+template <typename T>
+class StrokeBuffer {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;
+    static constexpr int32_t DEFAULT_RADIUS = 1;
+    static constexpr int32_t MAX_RADIUS = 1 << 15;  // Beyond any screen, and its square still fits in 32 bits
+
+    explicit StrokeBuffer(size_t capacity = DEFAULT_CAPACITY, int32_t radius = DEFAULT_RADIUS) {
+        setLimits(capacity, radius);
+    }
+
+    /**
+     * @brief Sets the capacity and the initial decimation radius; clears the stroke
+     * @param capacity Max number of stored points, at least 4
+     * @param radius Min distance in pixels between stored points; 0 or 1 only drops duplicates
+     */
+    void setLimits(size_t capacity, int32_t radius) {
+        m_capacity = capacity < 4 ? 4 : capacity;
+        m_initialRadius = radius < 1 ? 1 : radius;
+        m_points.clear();
+        m_points.shrink_to_fit();
+        m_points.reserve(m_capacity);
+        clear();
+    }
+
+    /**
+     * @brief Adds the latest position of the stroke
+     * @return false if the position equals the latest one and was ignored
+     */
+    bool add(int32_t x, int32_t y) {
+        if (!m_points.empty() && xOf(m_points.back()) == x && yOf(m_points.back()) == y) {
+            return false;
+        }
+
+        if (m_tailProvisional) {
+            m_points.pop_back();
+        }
+        if (m_points.size() == m_capacity) {
+            compact();
+        }
+        if (!m_points.empty()) {
+            int64_t dx = static_cast<int64_t>(x) - xOf(m_points.back());
+            int64_t dy = static_cast<int64_t>(y) - yOf(m_points.back());
+            m_tailProvisional = dx * dx + dy * dy < static_cast<int64_t>(m_radius) * m_radius;
+        }
+        m_points.push_back(T{x, y});
+        return true;
+    }
+
+    void clear() {
+        m_points.clear();
+        m_radius = m_initialRadius;
+        m_tailProvisional = false;
+    }
+
+    const std::vector<T>& points() const {
+        return m_points;
+    }
+
+    size_t size() const {
+        return m_points.size();
+    }
+
+    bool empty() const {
+        return m_points.empty();
+    }
+
+    const T& front() const {
+        return m_points.front();
+    }
+
+    const T& back() const {
+        return m_points.back();
+    }
+
+    size_t capacity() const {
+        return m_capacity;
+    }
+
+private:
+    // Keeps every other point, including the first one, and doubles the spacing of new points
+    void compact() {
+        size_t kept = 0;
+        for (size_t i = 0; i < m_points.size(); i += 2) {
+            m_points[kept++] = m_points[i];
+        }
+        m_points.resize(kept);
+        if (m_radius < MAX_RADIUS) {
+            m_radius *= 2;
+        }
+    }
+
+    template <typename P>
+    static auto xOf(const P& p) -> decltype(p.x) {
+        return p.x;
+    }
+    template <typename P>
+    static auto xOf(const P& p) -> decltype(p.first) {
+        return p.first;
+    }
+    template <typename P>
+    static auto yOf(const P& p) -> decltype(p.y) {
+        return p.y;
+    }
+    template <typename P>
+    static auto yOf(const P& p) -> decltype(p.second) {
+        return p.second;
+    }
+
+    std::vector<T> m_points;  // Reserved to m_capacity once, never reallocated while a stroke is recorded
+    size_t m_capacity = DEFAULT_CAPACITY;
+    int32_t m_initialRadius = DEFAULT_RADIUS;
+    int32_t m_radius = DEFAULT_RADIUS;  // Current decimation radius, doubled by every compaction
+    bool m_tailProvisional = false;     // The last point is closer than m_radius to the one before it
+};
+
+}  // namespace VirtualDesktop
@@ -1,5 +1,8 @@
 #pragma once
-#ifdef BUILDING_DLL
+#if !defined(_WIN32)
+// Outside Windows the platform-independent sources are compiled straight into the benchmarks and tests
+#define VDS_API
+#elif defined(BUILDING_DLL)
 #define VDS_API __declspec(dllexport)
 #else
 #define VDS_API __declspec(dllimport)
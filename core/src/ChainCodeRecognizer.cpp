@@ -0,0 +1,121 @@
+#include "ChainCodeRecognizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace VirtualDesktop {
+
+namespace {
+constexpr double TAN_22_5 = 0.41421356237309503;  // Boundary between an axis and a diagonal octant
+constexpr double COS_45 = 0.70710678118654752;     // Share of a diagonal segment projected on an axis
+
+// Bin indices of the axis directions; y grows downwards on screen
+constexpr int BIN_RIGHT = 0;
+constexpr int BIN_UP = 2;
+constexpr int BIN_LEFT = 4;
+constexpr int BIN_DOWN = 6;
+
+// Octant of a segment without trigonometry
+int directionBin(int32_t dx, int32_t dy) {
+    const double ax = std::abs(static_cast<double>(dx));
+    const double ay = std::abs(static_cast<double>(dy));
+    if (ay <= TAN_22_5 * ax) {
+        return dx > 0 ? BIN_RIGHT : BIN_LEFT;
+    }
+    if (ax <= TAN_22_5 * ay) {
+        return dy > 0 ? BIN_DOWN : BIN_UP;
+    }
+    if (dx > 0) {
+        return dy < 0 ? 1 : 7;
+    }
+    return dy < 0 ? 3 : 5;
+}
+}  // namespace
+
+void ChainCodeRecognizer::reset() {
+    std::fill(m_histogram, m_histogram + BINS, 0.0);
+    m_pathLength = 0.0;
+    m_started = false;
+}
+
+void ChainCodeRecognizer::addPoint(int32_t x, int32_t y) {
+    if (!m_started) {
+        m_firstX = m_lastX = m_anchorX = x;
+        m_firstY = m_lastY = m_anchorY = y;
+        m_started = true;
+        return;
+    }
+
+    m_lastX = x;
+    m_lastY = y;
+
+    // Segments are taken between anchors at least CHAIN_STEP apart, so pointer jitter does not spread
+    // the path over the perpendicular bins
+    const int32_t dx = x - m_anchorX;
+    const int32_t dy = y - m_anchorY;
+    const double length = std::hypot(static_cast<double>(dx), static_cast<double>(dy));
+    if (length < CHAIN_STEP) {
+        return;
+    }
+    m_histogram[directionBin(dx, dy)] += length;
+    m_pathLength += length;
+    m_anchorX = x;
+    m_anchorY = y;
+}
+
+double ChainCodeRecognizer::axisWeight(int bin) const {
+    return m_histogram[bin] + COS_45 * (m_histogram[(bin + 1) % BINS] + m_histogram[(bin + BINS - 1) % BINS]);
+}
+
+ChainCodeRecognizer::Direction ChainCodeRecognizer::recognize(const Positions& /*positions*/) const {
+    if (!m_started || m_pathLength <= 0.0) {
+        return Direction::None;
+    }
+
+    // Pick the axis direction carrying most of the path
+    const int axes[] = {BIN_RIGHT, BIN_UP, BIN_LEFT, BIN_DOWN};
+    int best = BIN_RIGHT;
+    for (int bin : axes) {
+        if (axisWeight(bin) > axisWeight(best)) {
+            best = bin;
+        }
+    }
+
+    const double dx = static_cast<double>(m_lastX - m_firstX);
+    const double dy = static_cast<double>(m_lastY - m_firstY);
+    double distance = 0.0;
+    switch (best) {
+        case BIN_RIGHT:
+            distance = dx;
+            break;
+        case BIN_UP:
+            distance = -dy;
+            break;
+        case BIN_LEFT:
+            distance = -dx;
+            break;
+        default:
+            distance = dy;
+            break;
+    }
+
+    // Reject short, wandering and back-and-forth strokes
+    const double opposite = axisWeight((best + BINS / 2) % BINS);
+    if (distance < MIN_DISTANCE || axisWeight(best) < MIN_DOMINANCE * m_pathLength ||
+        std::hypot(dx, dy) < MIN_STRAIGHTNESS * m_pathLength || opposite > MAX_BACKTRACK * m_pathLength) {
+        return Direction::None;
+    }
+
+    switch (best) {
+        case BIN_RIGHT:
+            return Direction::Right;
+        case BIN_UP:
+            return Direction::Up;
+        case BIN_LEFT:
+            return Direction::Left;
+        default:
+            return Direction::Down;
+    }
+}
+
+}  // namespace VirtualDesktop
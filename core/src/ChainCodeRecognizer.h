@@ -0,0 +1,41 @@
+#pragma once
+#include "IGestureRecognizer.h"
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Classifies a stroke from a running 8-direction chain-code histogram
+ *
+ * Every segment adds its length to the bin of its direction, so addPoint() and recognize() both take constant
+ * time however long the stroke is. A direction is recognized when its axis dominates the histogram, the stroke
+ * is straight enough and little of it runs backwards.
+ */
+class ChainCodeRecognizer : public IGestureRecognizer {
+public:
+    void reset() override;
+    void addPoint(int32_t x, int32_t y) override;
+    Direction recognize(const Positions& positions) const override;
+
+private:
+    static constexpr int BINS = 8;                   // Directions, counter-clockwise from right in screen space
+    static constexpr double CHAIN_STEP = 8.0;        // Min length of a chain segment in pixels
+    static constexpr double MIN_DISTANCE = 50.0;     // Min displacement along the recognized axis in pixels
+    static constexpr double MIN_DOMINANCE = 0.6;     // Min share of the path length along the recognized axis
+    static constexpr double MIN_STRAIGHTNESS = 0.5;  // Min ratio of the displacement to the path length
+    static constexpr double MAX_BACKTRACK = 0.15;    // Max share of the path length against the recognized axis
+
+    // Path length projected on an axis direction: the axis bin and its diagonal neighbours at 45 degrees
+    double axisWeight(int bin) const;
+
+    double m_histogram[BINS] = {};
+    double m_pathLength = 0.0;
+    int32_t m_firstX = 0;
+    int32_t m_firstY = 0;
+    int32_t m_lastX = 0;
+    int32_t m_lastY = 0;
+    int32_t m_anchorX = 0;  // End of the last chain segment
+    int32_t m_anchorY = 0;
+    bool m_started = false;
+};
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,173 @@
+#include "ConfigWatcher.h"
+#include "utils.h"
+#include <initializer_list>
+#include <utility>
+
+namespace VirtualDesktop {
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+bool ConfigWatcher::start(Settings& settings, const std::wstring& filePath, ReloadCallback onReload) {
+    stop();
+    m_settings = &settings;
+    m_filePath = filePath;
+    m_onReload = std::move(onReload);
+    m_stamp = readStamp();
+    m_stopping.store(false);
+
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (m_wakeEvent == nullptr) {
+        return false;
+    }
+    m_thread = CreateThread(nullptr, 0, threadProc, this, 0, nullptr);
+    if (m_thread == nullptr) {
+        CloseHandle(m_wakeEvent);
+        m_wakeEvent = nullptr;
+        return false;
+    }
+
+    // Every setter call schedules a save; the thread waits SAVE_DELAY_MS for the burst to end
+    m_settings->setChangeCallback([this]() {
+        requestSave();
+    });
+    return true;
+}
+
+void ConfigWatcher::stop() {
+    if (m_thread != nullptr) {
+        m_settings->setChangeCallback(nullptr);
+        m_stopping.store(true);
+        SetEvent(m_wakeEvent);
+        WaitForSingleObject(m_thread, INFINITE);
+        CloseHandle(m_thread);
+        m_thread = nullptr;
+    }
+    if (m_wakeEvent != nullptr) {
+        CloseHandle(m_wakeEvent);
+        m_wakeEvent = nullptr;
+    }
+}
+
+void ConfigWatcher::requestSave() {
+    m_saveRequested.store(true);
+    if (m_wakeEvent != nullptr) {
+        SetEvent(m_wakeEvent);
+    }
+}
+
+DWORD WINAPI ConfigWatcher::threadProc(LPVOID param) {
+    static_cast<ConfigWatcher*>(param)->run();
+    return 0;
+}
+
+void ConfigWatcher::run() {
+    // Watch the directory, since editors often replace the file instead of writing it in place
+    std::wstring directory = m_filePath.substr(0, m_filePath.find_last_of(L"\\/") + 1);
+    HANDLE change = FindFirstChangeNotificationW(
+            directory.empty() ? L"." : directory.c_str(),
+            FALSE,
+            FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE | FILE_NOTIFY_CHANGE_LAST_WRITE);
+    if (change == INVALID_HANDLE_VALUE) {
+        trace("Cannot watch %ls, polling for config changes", directory.c_str());
+        change = nullptr;
+    }
+
+    // Deadlines in GetTickCount64() milliseconds, 0 when nothing is pending
+    ULONGLONG reloadAt = 0;
+    ULONGLONG saveAt = 0;
+    ULONGLONG pollAt = change == nullptr ? GetTickCount64() + POLL_INTERVAL_MS : 0;
+    for (;;) {
+        ULONGLONG now = GetTickCount64();
+        if (pollAt != 0 && pollAt <= now) {
+            pollAt = now + POLL_INTERVAL_MS;
+            reloadIfChanged();
+        }
+        if (reloadAt != 0 && reloadAt <= now) {
+            reloadAt = 0;
+            reloadIfChanged();
+        }
+        if (saveAt != 0 && saveAt <= now) {
+            saveAt = 0;
+            saveIfDirty();
+        }
+
+        ULONGLONG next = 0;
+        for (ULONGLONG deadline : {reloadAt, saveAt, pollAt}) {
+            if (deadline != 0 && (next == 0 || deadline < next)) {
+                next = deadline;
+            }
+        }
+        DWORD timeout = next == 0 ? INFINITE : static_cast<DWORD>(next > now ? next - now : 0);
+
+        HANDLE handles[2] = {m_wakeEvent, change};
+        DWORD result = WaitForMultipleObjects(change != nullptr ? 2 : 1, handles, FALSE, timeout);
+        if (result == WAIT_OBJECT_0) {
+            if (m_stopping.load()) {
+                break;
+            }
+            if (m_saveRequested.exchange(false)) {
+                saveAt = GetTickCount64() + SAVE_DELAY_MS;
+            }
+        } else if (result == WAIT_OBJECT_0 + 1) {
+            // Every notification restarts the delay, so a file still being written is parsed once, when it is done
+            FindNextChangeNotification(change);
+            reloadAt = GetTickCount64() + RELOAD_DELAY_MS;
+        } else if (result == WAIT_FAILED) {
+            trace("Config watcher wait failed: %lu", GetLastError());
+            break;
+        }
+    }
+
+    if (change != nullptr) {
+        FindCloseChangeNotification(change);
+    }
+    saveIfDirty();
+}
+
+ConfigWatcher::FileStamp ConfigWatcher::readStamp() const {
+    FileStamp stamp;
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (GetFileAttributesExW(m_filePath.c_str(), GetFileExInfoStandard, &data)) {
+        stamp.lastWrite = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                          data.ftLastWriteTime.dwLowDateTime;
+        stamp.size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        stamp.exists = true;
+    }
+    return stamp;
+}
+
+void ConfigWatcher::reloadIfChanged() {
+    FileStamp stamp = readStamp();
+    if (stamp == m_stamp) {
+        return;  // Another file in the directory changed, or this is our own save
+    }
+    m_stamp = stamp;
+    if (!stamp.exists) {
+        return;  // Deleted or being replaced; the settings stay as they are
+    }
+
+    // An edit on disk wins over unsaved changes
+    if (m_settings->reload(m_filePath)) {
+        trace("Config file reloaded");
+        if (m_onReload) {
+            m_onReload();
+        }
+    } else {
+        trace("Ignoring invalid config file %ls", m_filePath.c_str());
+    }
+}
+
+void ConfigWatcher::saveIfDirty() {
+    if (!m_settings->isDirty()) {
+        return;
+    }
+    if (m_settings->save(m_filePath)) {
+        m_stamp = readStamp();
+    } else {
+        trace("Failed to save config file %ls", m_filePath.c_str());
+    }
+}
+
+}  // namespace VirtualDesktop
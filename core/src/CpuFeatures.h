@@ -0,0 +1,57 @@
+#pragma once
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VDS_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC accepts intrinsics for any instruction set; GCC and Clang need the target enabled per function
+#if defined(__GNUC__)
+#define VDS_TARGET(arch) __attribute__((target(arch)))
+#else
+#define VDS_TARGET(arch)
+#endif
+
+namespace VirtualDesktop {
+
+#ifdef VDS_KERNELS_X86
+
+// Whether the CPU has AVX2 and the OS saves the YMM registers
+inline bool cpuSupportsAvx2() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    // AVX needs both CPU support and the OS saving the YMM registers on context switch
+    __cpuid(info, 1);
+    const bool osSavesYmm = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+    if (!osSavesYmm) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+inline bool cpuSupportsSse2() {
+#if defined(_M_X64) || defined(__x86_64__)
+    return true;
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif  // VDS_KERNELS_X86
+
+}  // namespace VirtualDesktop
@@ -1,7 +1,6 @@
 ﻿#include "GdiRenderer.h"
 #include <algorithm>
 #include <cstdint>
-#include <cmath>
 #include <cstring>
 
 namespace VirtualDesktop {
@@ -9,45 +8,22 @@ namespace VirtualDesktop {
 GdiRenderer::GdiRenderer() :
         m_hwnd(nullptr),
         m_windowDC(nullptr),
-        m_memoryDC(nullptr),
-        m_bitmap(nullptr),
-        m_oldBitmap(nullptr),
-        m_backgroundBrush(nullptr),
-        m_pen(nullptr),
         m_trailColor(RGB(100, 149, 237)),  // Default: Cornflower Blue
         m_alpha(0xAA),
         m_lineWidth(5.0f),
         m_width(0),
         m_height(0),
-        m_pBits(nullptr) {
+        m_memoryDC(nullptr),
+        m_bitmap(nullptr),
+        m_oldBitmap(nullptr),
+        m_pBits(nullptr),
+        m_rcStaging{},
+        m_rcWindow{} {
 }
 
 GdiRenderer::~GdiRenderer() {
     // Clean up GDI resources
-    if (m_pen) {
-        DeleteObject(m_pen);
-        m_pen = nullptr;
-    }
-
-    if (m_backgroundBrush) {
-        DeleteObject(m_backgroundBrush);
-        m_backgroundBrush = nullptr;
-    }
-
-    if (m_memoryDC && m_oldBitmap) {
-        SelectObject(m_memoryDC, m_oldBitmap);
-        m_oldBitmap = nullptr;
-    }
-
-    if (m_bitmap) {
-        DeleteObject(m_bitmap);
-        m_bitmap = nullptr;
-    }
-
-    if (m_memoryDC) {
-        DeleteDC(m_memoryDC);
-        m_memoryDC = nullptr;
-    }
+    releaseSurface();
 
     if (m_windowDC && m_hwnd) {
         ReleaseDC(m_hwnd, m_windowDC);
@@ -66,16 +42,30 @@ bool parseHexComponent(const std::string& hex, size_t offset, BYTE& result) {
     }
 }
 
-// Helper: convert RGBA (0-255) to premultiplied BGRA dword
-// inline uint32_t premultiplied_bgra(BYTE r, BYTE g, BYTE b, BYTE a) {
-//     // premultiply color channels by alpha
-//     float af = a / 255.0f;
-//     BYTE pr = static_cast<BYTE>(std::round(r * af));
-//     BYTE pg = static_cast<BYTE>(std::round(g * af));
-//     BYTE pb = static_cast<BYTE>(std::round(b * af));
-//     return (static_cast<uint32_t>(a) << 24) | (static_cast<uint32_t>(pr) << 16) | (static_cast<uint32_t>(pg) << 8) |
-//             (static_cast<uint32_t>(pb));
-// }
+bool isEmptyRect(const RECT& rc) {
+    return rc.left >= rc.right || rc.top >= rc.bottom;
+}
+
+bool containsRect(const RECT& outer, const RECT& inner) {
+    return inner.left >= outer.left && inner.top >= outer.top && inner.right <= outer.right &&
+            inner.bottom <= outer.bottom;
+}
+
+// Screen point in the surface coordinates of the canvas
+TrailCanvas::Point toSurface(const POINT& pt, const RECT& rcVirtual) {
+    return {static_cast<int32_t>(pt.x - rcVirtual.left), static_cast<int32_t>(pt.y - rcVirtual.top)};
+}
+
+RECT uniteRects(const RECT& a, const RECT& b) {
+    if (isEmptyRect(a)) {
+        return b;
+    }
+    if (isEmptyRect(b)) {
+        return a;
+    }
+    return {std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom)};
+}
+
 }  // namespace
 
 COLORREF GdiRenderer::hexToCOLORREF(const std::string& hex) {
@@ -96,13 +86,10 @@ void GdiRenderer::setTrailStyle(const std::string& colorHex, float lineWidth) {
     m_trailColor = hexToCOLORREF(colorHex);
     m_lineWidth = std::clamp(lineWidth, 1.0f, 10.0f);
 
-    if (m_pen) {
-        DeleteObject(m_pen);
-        m_pen = nullptr;
-    }
-
-    // Create a pen with the RGB color; alpha will be applied per-pixel in bitmap
-    m_pen = CreatePen(PS_SOLID | PS_ENDCAP_ROUND | PS_JOIN_ROUND, static_cast<int>(m_lineWidth), m_trailColor);
+    // The canvas takes 0x00RRGGBB, COLORREF is 0x00BBGGRR
+    uint32_t color = (static_cast<uint32_t>(GetRValue(m_trailColor)) << 16) |
+            (static_cast<uint32_t>(GetGValue(m_trailColor)) << 8) | GetBValue(m_trailColor);
+    m_canvas.setStyle(color, m_alpha, m_lineWidth);
 }
 
 void GdiRenderer::computeVirtualScreenRect() {
@@ -114,6 +101,7 @@ void GdiRenderer::computeVirtualScreenRect() {
 
     m_width = std::max((LONG)1, m_rcVirtual.right - m_rcVirtual.left);
     m_height = std::max((LONG)1, m_rcVirtual.bottom - m_rcVirtual.top);
+    m_canvas.resize(m_width, m_height);
 }
 
 bool GdiRenderer::initialize(HWND hwndParent) {
@@ -124,84 +112,80 @@ bool GdiRenderer::initialize(HWND hwndParent) {
 
     // Get the window DC
     m_windowDC = GetDC(m_hwnd);
-
-    // Create memory DC
-    m_memoryDC = CreateCompatibleDC(m_windowDC);
-
-    // Create32-bit DIB section with alpha channel (BI_BITFIELDS)
-    BITMAPV5HEADER bi = {};
-    bi.bV5Size = sizeof(BITMAPV5HEADER);
-    bi.bV5Width = m_width;
-    bi.bV5Height = -m_height;  // top-down
-    bi.bV5Planes = 1;
-    bi.bV5BitCount = 32;
-    bi.bV5Compression = BI_BITFIELDS;
-    bi.bV5RedMask = 0x00FF0000;
-    bi.bV5GreenMask = 0x0000FF00;
-    bi.bV5BlueMask = 0x000000FF;
-    bi.bV5AlphaMask = 0xFF000000;
-
-    m_pBits = nullptr;
-    m_bitmap = CreateDIBSection(m_windowDC, (BITMAPINFO*)&bi, DIB_RGB_COLORS, &m_pBits, nullptr, 0);
-
-    if (!m_bitmap || !m_pBits) {
-        if (m_windowDC) {
-            ReleaseDC(m_hwnd, m_windowDC);
-            m_windowDC = nullptr;
-        }
+    if (!m_windowDC) {
         return false;
     }
 
-    m_oldBitmap = (HBITMAP)SelectObject(m_memoryDC, m_bitmap);
+    // The tiles and the staging DIB are allocated by prepare() and render() when a gesture starts
+    return true;
+}
 
-    // Create background brush (black) for clearing; actual alpha defined in pixel data
-    m_backgroundBrush = CreateSolidBrush(RGB(0, 0, 0));
+void GdiRenderer::resizeForMonitors() {
+    // Tiles are laid out on the virtual screen, so the trail and its staging start over
+    releaseStaging();
+    computeVirtualScreenRect();
+    m_rcWindow = {};  // Whatever the window shows, the next frame replaces all of it
+}
 
-    // Initialize pen
-    if (m_pen == nullptr) {
-        m_pen = CreatePen(PS_SOLID | PS_ENDCAP_ROUND | PS_JOIN_ROUND, static_cast<int>(m_lineWidth), m_trailColor);
-    }
+bool GdiRenderer::prepare() {
+    return m_memoryDC != nullptr || createSurface();
+}
 
-    return true;
+void GdiRenderer::trim() {
+    releaseSurface();
+    m_rcWindow = {};
 }
 
-void GdiRenderer::resizeForMonitors() {
-    // Clean up old resources
-    if (m_pen) {
-        DeleteObject(m_pen);
-        m_pen = nullptr;
-    }
+size_t GdiRenderer::surfaceBytes() const {
+    size_t staging = static_cast<size_t>(m_rcStaging.right - m_rcStaging.left) *
+            static_cast<size_t>(m_rcStaging.bottom - m_rcStaging.top) * 4;
+    return m_canvas.bytes() + (m_bitmap ? staging : 0);
+}
 
-    if (m_backgroundBrush) {
-        DeleteObject(m_backgroundBrush);
-        m_backgroundBrush = nullptr;
+bool GdiRenderer::createSurface() {
+    if (!m_windowDC) {
+        return false;
     }
 
-    if (m_memoryDC && m_oldBitmap) {
-        SelectObject(m_memoryDC, m_oldBitmap);
-        m_oldBitmap = nullptr;
-    }
+    m_memoryDC = CreateCompatibleDC(m_windowDC);
+    return m_memoryDC != nullptr;
+}
 
-    if (m_bitmap) {
-        DeleteObject(m_bitmap);
-        m_bitmap = nullptr;
-        m_pBits = nullptr;
-    }
+void GdiRenderer::releaseSurface() {
+    releaseStaging();
+    m_canvas.release();
 
     if (m_memoryDC) {
         DeleteDC(m_memoryDC);
         m_memoryDC = nullptr;
     }
+}
 
-    // Reinitialize with new dimensions
-    computeVirtualScreenRect();
+bool GdiRenderer::ensureStaging(const RECT& needed) {
+    if (m_bitmap && containsRect(m_rcStaging, needed)) {
+        return true;
+    }
+    if (!m_memoryDC) {
+        return false;
+    }
 
-    m_memoryDC = CreateCompatibleDC(m_windowDC);
+    // Grow around the union of the old and needed areas, aligned to tiles and clipped to the surface. The margin
+    // is a quarter of the size, so a trail that keeps spreading only regrows the DIB a logarithmic number of times.
+    const LONG tile = TiledSurface::TILE_SIZE;
+    RECT area = m_bitmap ? uniteRects(needed, m_rcStaging) : needed;
+    const LONG marginX = std::max<LONG>(STAGING_MARGIN_TILES, (area.right - area.left) / tile / 4) * tile;
+    const LONG marginY = std::max<LONG>(STAGING_MARGIN_TILES, (area.bottom - area.top) / tile / 4) * tile;
+    area.left = std::max(0L, area.left - marginX);
+    area.top = std::max(0L, area.top - marginY);
+    area.right = std::min(m_width, area.right + marginX);
+    area.bottom = std::min(m_height, area.bottom + marginY);
+
+    releaseStaging();
 
     BITMAPV5HEADER bi = {};
     bi.bV5Size = sizeof(BITMAPV5HEADER);
-    bi.bV5Width = m_width;
-    bi.bV5Height = -m_height;
+    bi.bV5Width = area.right - area.left;
+    bi.bV5Height = -(area.bottom - area.top);  // top-down
     bi.bV5Planes = 1;
     bi.bV5BitCount = 32;
     bi.bV5Compression = BI_BITFIELDS;
@@ -210,203 +194,175 @@ void GdiRenderer::resizeForMonitors() {
     bi.bV5BlueMask = 0x000000FF;
     bi.bV5AlphaMask = 0xFF000000;
 
-    m_pBits = nullptr;
-    m_bitmap = CreateDIBSection(m_windowDC, (BITMAPINFO*)&bi, DIB_RGB_COLORS, &m_pBits, nullptr, 0);
+    // The section starts zeroed, which is fully transparent
+    void* bits = nullptr;
+    m_bitmap = CreateDIBSection(m_windowDC, (BITMAPINFO*)&bi, DIB_RGB_COLORS, &bits, nullptr, 0);
+    if (!m_bitmap || !bits) {
+        releaseStaging();
+        return false;
+    }
+    m_pBits = static_cast<uint32_t*>(bits);
+    m_oldBitmap = (HBITMAP)SelectObject(m_memoryDC, m_bitmap);
+    m_rcStaging = area;
 
+    for (const TiledSurface::Tile& tile : m_canvas.surface().tiles()) {
+        stageTile(tile);
+    }
+    return true;
+}
+
+void GdiRenderer::releaseStaging() {
+    if (m_memoryDC && m_oldBitmap) {
+        SelectObject(m_memoryDC, m_oldBitmap);
+        m_oldBitmap = nullptr;
+    }
     if (m_bitmap) {
-        m_oldBitmap = (HBITMAP)SelectObject(m_memoryDC, m_bitmap);
-        m_backgroundBrush = CreateSolidBrush(RGB(0, 0, 0));
-        m_pen = CreatePen(PS_SOLID | PS_ENDCAP_ROUND | PS_JOIN_ROUND, static_cast<int>(m_lineWidth), m_trailColor);
+        DeleteObject(m_bitmap);
+        m_bitmap = nullptr;
     }
+    m_pBits = nullptr;
+    m_rcStaging = {};
 }
 
-void GdiRenderer::drawSmoothTrail(const std::vector<POINT>& points) {
-    if (points.size() < 2)
-        return;
+void GdiRenderer::stageTile(const TiledSurface::Tile& tile) {
+    // Tiles on the right and bottom edges stick out of the surface and the staging area
+    const LONG x = tile.tx * TiledSurface::TILE_SIZE;
+    const LONG y = tile.ty * TiledSurface::TILE_SIZE;
+    const LONG stride = m_rcStaging.right - m_rcStaging.left;
+    const LONG columns = std::min<LONG>(TiledSurface::TILE_SIZE, m_rcStaging.right - x);
+    const LONG rows = std::min<LONG>(TiledSurface::TILE_SIZE, m_rcStaging.bottom - y);
+    uint32_t* dst = m_pBits + (y - m_rcStaging.top) * stride + (x - m_rcStaging.left);
+    for (LONG row = 0; row < rows; ++row) {
+        memcpy(dst + row * stride, tile.pixels + row * TiledSurface::TILE_SIZE, columns * sizeof(uint32_t));
+    }
+}
 
-    // Convert points to memory DC coordinates
-    std::vector<POINT> convertedPoints;
-    convertedPoints.reserve(points.size());
+void GdiRenderer::unstageTile(int tx, int ty) {
+    const LONG x = tx * TiledSurface::TILE_SIZE;
+    const LONG y = ty * TiledSurface::TILE_SIZE;
+    if (!m_pBits || x < m_rcStaging.left || y < m_rcStaging.top || x >= m_rcStaging.right ||
+        y >= m_rcStaging.bottom) {
+        return;
+    }
+    const LONG stride = m_rcStaging.right - m_rcStaging.left;
+    const LONG columns = std::min<LONG>(TiledSurface::TILE_SIZE, m_rcStaging.right - x);
+    const LONG rows = std::min<LONG>(TiledSurface::TILE_SIZE, m_rcStaging.bottom - y);
+    uint32_t* dst = m_pBits + (y - m_rcStaging.top) * stride + (x - m_rcStaging.left);
+    for (LONG row = 0; row < rows; ++row) {
+        memset(dst + row * stride, 0, columns * sizeof(uint32_t));
+    }
+}
 
-    for (const auto& pt : points) {
-        POINT convertedPt = {pt.x - m_rcVirtual.left, pt.y - m_rcVirtual.top};
-        convertedPoints.push_back(convertedPt);
+void GdiRenderer::present(const RECT* dirty) {
+    // The layered window covers the staging area. While it stays in place only the dirty area is copied from
+    // the staging DIB; once the staging area moved or grew, all of it is.
+    bool moved = m_rcWindow.left != m_rcStaging.left || m_rcWindow.top != m_rcStaging.top ||
+            m_rcWindow.right != m_rcStaging.right || m_rcWindow.bottom != m_rcStaging.bottom;
+    RECT rcDirty = {};
+    if (dirty) {
+        rcDirty = {
+                dirty->left - m_rcStaging.left,
+                dirty->top - m_rcStaging.top,
+                dirty->right - m_rcStaging.left,
+                dirty->bottom - m_rcStaging.top};
     }
 
-    // Draw the entire polyline at once for smoother appearance
-    SelectObject(m_memoryDC, m_pen);
-    Polyline(m_memoryDC, convertedPoints.data(), static_cast<int>(convertedPoints.size()));
+    HDC screenDC = GetDC(NULL);
+    BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
+    POINT srcPoint = {0, 0};
+    SIZE size = {m_rcStaging.right - m_rcStaging.left, m_rcStaging.bottom - m_rcStaging.top};
+    POINT destPoint = {m_rcVirtual.left + m_rcStaging.left, m_rcVirtual.top + m_rcStaging.top};
+
+    UPDATELAYEREDWINDOWINFO info = {};
+    info.cbSize = sizeof(info);
+    info.hdcDst = screenDC;
+    info.pptDst = &destPoint;
+    info.psize = &size;
+    info.hdcSrc = m_memoryDC;
+    info.pptSrc = &srcPoint;
+    info.pblend = &blend;
+    info.dwFlags = ULW_ALPHA;
+    info.prcDirty = dirty && !moved ? &rcDirty : nullptr;
+    UpdateLayeredWindowIndirect(m_hwnd, &info);
+
+    ReleaseDC(NULL, screenDC);
+    m_rcWindow = m_rcStaging;
 }
 
-// Postprocess the DIB bits: set per-pixel alpha where drawn pixels match trail color and make premultiplied
-// Now only processes pixels inside the provided rectangle [left, top) x [right, bottom)
-static void postprocess_bits_range(
-        void* bits,
-        int fullWidth,
-        int fullHeight,
-        int left,
-        int top,
-        int right,
-        int bottom,
-        COLORREF trailColor,
-        BYTE alpha) {
-    if (!bits)
-        return;
-    // Clip rectangle to bitmap bounds
-    if (left < 0)
-        left = 0;
-    if (top < 0)
-        top = 0;
-    if (right > fullWidth)
-        right = fullWidth;
-    if (bottom > fullHeight)
-        bottom = fullHeight;
-    if (left >= right || top >= bottom)
-        return;
+void GdiRenderer::presentDrawnTiles(bool dirtyOnly) {
+    const TrailCanvas::Rect& tiles = m_canvas.area();
+    const TrailCanvas::Rect& drawn = m_canvas.drawnArea();
+    RECT area = {tiles.left, tiles.top, tiles.right, tiles.bottom};
+    RECT dirty = {drawn.left, drawn.top, drawn.right, drawn.bottom};
 
-    uint8_t* ptr = reinterpret_cast<uint8_t*>(bits);
-    // bits are BGRA in memory (little endian: B,G,R,A)
-    const BYTE tr = GetRValue(trailColor);
-    const BYTE tg = GetGValue(trailColor);
-    const BYTE tb = GetBValue(trailColor);
-
-    for (int y = top; y < bottom; ++y) {
-        // pointer to beginning of this row
-        uint32_t* row = reinterpret_cast<uint32_t*>(ptr + y * fullWidth * 4);
-        for (int x = left; x < right; ++x) {
-            uint32_t pixel = row[x];
-            BYTE b = static_cast<BYTE>(pixel & 0xFF);
-            BYTE g = static_cast<BYTE>((pixel >> 8) & 0xFF);
-            BYTE r = static_cast<BYTE>((pixel >> 16) & 0xFF);
-
-            // If pixel is black (background) keep it fully transparent
-            if (r == 0 && g == 0 && b == 0) {
-                row[x] = 0x00000000;
-                continue;
-            }
-
-            // If pixel matches the trail color (ignoring alpha), set requested alpha and premultiply
-            if (r == tr && g == tg && b == tb) {
-                // premultiply
-                float af = alpha / 255.0f;
-                BYTE pr = static_cast<BYTE>(std::round(r * af));
-                BYTE pg = static_cast<BYTE>(std::round(g * af));
-                BYTE pb = static_cast<BYTE>(std::round(b * af));
-                row[x] = (static_cast<uint32_t>(alpha) << 24) | (static_cast<uint32_t>(pr) << 16) |
-                        (static_cast<uint32_t>(pg) << 8) | (static_cast<uint32_t>(pb));
-            } else {
-                // For anti-aliased edges or unexpected colors, compute alpha based on intensity toward trail color
-                int dr = static_cast<int>(r) - static_cast<int>(tr);
-                int dg = static_cast<int>(g) - static_cast<int>(tg);
-                int db = static_cast<int>(b) - static_cast<int>(tb);
-                int dist2 = dr * dr + dg * dg + db * db;
-                double dist = std::sqrt(static_cast<double>(dist2));
-                double ratio = dist / 255.0;  // 0..~3
-                double minVal = std::min(1.0, ratio);
-                float sim = 1.0f - static_cast<float>(minVal);
-                BYTE newA = static_cast<BYTE>(std::round(alpha * sim));
-                float af = newA / 255.0f;
-                BYTE pr = static_cast<BYTE>(std::round(r * af));
-                BYTE pg = static_cast<BYTE>(std::round(g * af));
-                BYTE pb = static_cast<BYTE>(std::round(b * af));
-                row[x] = (static_cast<uint32_t>(newA) << 24) | (static_cast<uint32_t>(pr) << 16) |
-                        (static_cast<uint32_t>(pg) << 8) | (static_cast<uint32_t>(pb));
-            }
+    // Copy the drawn tiles into the staging DIB; a regrown one already holds all of them, and the window with it
+    // has to be presented in full
+    bool covered = m_bitmap && containsRect(m_rcStaging, area);
+    if (!ensureStaging(area)) {
+        return;
+    }
+    if (covered) {
+        for (const TiledSurface::Tile& tile : m_canvas.drawnTiles()) {
+            stageTile(tile);
         }
     }
+    present(covered && dirtyOnly ? &dirty : nullptr);
 }
 
 void GdiRenderer::render(const std::vector<POINT>& points) {
-    if (points.size() < 2 || !m_memoryDC || !m_pen) {
+    // A single point draws nothing, but append() continues the trail from it
+    if (points.empty() || !prepare()) {
         return;
     }
 
-    // Set up drawing
-    SetGraphicsMode(m_memoryDC, GM_ADVANCED);
-    SetBkMode(m_memoryDC, TRANSPARENT);
-
-    // Clear the background to black (transparent after postprocess)
-    RECT rc = {0, 0, m_width, m_height};
-    FillRect(m_memoryDC, &rc, m_backgroundBrush);
-
-    // Compute converted points and bounding rectangle in memory coordinates
-    std::vector<POINT> convertedPoints;
-    convertedPoints.reserve(points.size());
-    int minX = INT_MAX, minY = INT_MAX, maxX = INT_MIN, maxY = INT_MIN;
+    // Convert points to surface coordinates
+    m_convertedPoints.clear();
     for (const auto& pt : points) {
-        POINT c = {pt.x - m_rcVirtual.left, pt.y - m_rcVirtual.top};
-        convertedPoints.push_back(c);
-        minX = std::min(minX, static_cast<int>(c.x));
-        minY = std::min(minY, static_cast<int>(c.y));
-        maxX = std::max(maxX, static_cast<int>(c.x));
-        maxY = std::max(maxY, static_cast<int>(c.y));
+        m_convertedPoints.push_back(toSurface(pt, m_rcVirtual));
+    }
+    m_canvas.render(m_convertedPoints.data(), m_convertedPoints.size());
+    for (const TiledSurface::Tile& tile : m_canvas.erasedTiles()) {
+        unstageTile(tile.tx, tile.ty);
     }
 
-    // Add padding to include line width and antialiasing edges
-    int pad = static_cast<int>(std::ceil(m_lineWidth)) + 2;
-    int left = (minX == INT_MAX) ? 0 : (minX - pad);
-    int top = (minY == INT_MAX) ? 0 : (minY - pad);
-    int right = (maxX == INT_MIN) ? 0 : (maxX + pad + 1);
-    int bottom = (maxY == INT_MIN) ? 0 : (maxY + pad + 1);
-
-    // Clamp to bitmap
-    left = std::max(0, left);
-    top = std::max(0, top);
-    right = std::min(static_cast<int>(m_width), right);
-    bottom = std::min(static_cast<int>(m_height), bottom);
-
-    // Draw the trail with enhanced smoothness
-    drawSmoothTrail(points);
-
-    // Postprocess only the bounding rectangle
-    postprocess_bits_range(
-            m_pBits,
-            static_cast<int>(m_width),
-            static_cast<int>(m_height),
-            left,
-            top,
-            right,
-            bottom,
-            m_trailColor,
-            m_alpha);
-
-    // Update only the bounding rectangle area of the layered window
-    HDC screenDC = GetDC(NULL);
-    BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
-    POINT srcPoint = {left, top};
-    SIZE size = {right - left, bottom - top};
-    POINT destPoint = {m_rcVirtual.left + left, m_rcVirtual.top + top};
+    if (m_canvas.surface().empty()) {
+        if (m_bitmap) {
+            present(nullptr);  // The trail left the screen
+        }
+        return;
+    }
+    presentDrawnTiles(false);
+}
 
-    // UpdateLayeredWindow will use the specified source rectangle from m_memoryDC
-    UpdateLayeredWindow(m_hwnd, screenDC, &destPoint, &size, m_memoryDC, &srcPoint, 0, &blend, ULW_ALPHA);
+void GdiRenderer::append(const POINT& point) {
+    // Without a surface the point still becomes the start of the next segment
+    bool ready = prepare();
+    m_canvas.append(toSurface(point, m_rcVirtual));
+    if (!ready || m_canvas.drawnTiles().empty()) {
+        return;
+    }
 
-    ReleaseDC(NULL, screenDC);
+    // Present only the changed tiles, unless the staging DIB had to grow and the window with it
+    presentDrawnTiles(true);
 }
 
 void GdiRenderer::clear() {
-    if (!m_memoryDC) {
+    m_rcWindow = {};  // Whatever the window shows, the next frame replaces all of it
+    if (!m_bitmap) {
+        m_canvas.clear();
         return;
     }
 
-    // Clear to black
-    RECT rc = {0, 0, m_width, m_height};
-    FillRect(m_memoryDC, &rc, m_backgroundBrush);
-
-    // Also clear pixel bits to zero (fully transparent)
-    if (m_pBits) {
-        memset(m_pBits, 0, static_cast<size_t>(m_width) * static_cast<size_t>(m_height) * 4);
+    // Clear the staged tiles to zero (fully transparent) and hand the tiles back to the pool
+    for (const TiledSurface::Tile& tile : m_canvas.surface().tiles()) {
+        unstageTile(tile.tx, tile.ty);
     }
+    m_canvas.clear();
 
-    // Update only the full window area when clearing (we clear whole bitmap)
-    HDC screenDC = GetDC(NULL);
-    BLENDFUNCTION blend = {AC_SRC_OVER, 0, 255, AC_SRC_ALPHA};
-    POINT srcPoint = {0, 0};
-    SIZE size = {m_width, m_height};
-    POINT destPoint = {m_rcVirtual.left, m_rcVirtual.top};
-
-    UpdateLayeredWindow(m_hwnd, screenDC, &destPoint, &size, m_memoryDC, &srcPoint, 0, &blend, ULW_ALPHA);
-
-    ReleaseDC(NULL, screenDC);
+    // Present the empty staging area so the next gesture does not briefly show the old trail, then drop it:
+    // the next gesture is usually somewhere else
+    present(nullptr);
+    releaseStaging();
 }
 
-}  // namespace VirtualDesktop
\ No newline at end of file
+}  // namespace VirtualDesktop
@@ -1,13 +1,23 @@
 ﻿#pragma once
 #include "IRenderer.h"
+#include "TrailCanvas.h"
 #include <Windows.h>
+#include <cstdint>
 #include <string>
 #include <vector>
 
 namespace VirtualDesktop {
 
 /**
- * @brief Renders mouse trail using Windows GDI for gesture visualization
+ * @brief Presents the mouse trail in a layered window for gesture visualization
+ *
+ * The trail is drawn by TrailCanvas, which anti-aliases it in software straight into premultiplied BGRA tiles, so
+ * no GDI drawing or pixel post-process is involved. This class only copies the tiles into a staging DIB covering
+ * their bounding box and feeds it to UpdateLayeredWindow, which needs one contiguous source. Memory follows the
+ * trail instead of the virtual screen, and trim() releases all of it while no gesture is shown.
+ *
+ * render() redraws a whole trail, while append() only adds the newest segment to the tiles it passes through
+ * and updates just those in the layered window, so its cost does not depend on the length of the trail.
  */
 class GdiRenderer : public IRenderer {
 public:
@@ -39,19 +49,38 @@ public:
      */
     void render(const std::vector<POINT>& points) override;
 
+    /**
+     * @brief Draws the segment from the last drawn point to a new one, and presents only the tiles it touches
+     * @param point New end of the trail in screen coordinates
+     */
+    void append(const POINT& point) override;
+
     /**
      * @brief Clears the rendered trail
      */
     void clear() override;
 
+    /**
+     * @brief Creates the memory DC the staging DIB is selected into, if it was not created yet or was trimmed
+     * @return true if the renderer can draw
+     */
+    bool prepare() override;
+
+    /**
+     * @brief Releases the tile pool, the staging DIB and the memory DC
+     */
+    void trim() override;
+
+    /**
+     * @brief Returns the bytes held by the tile pool and the staging DIB
+     */
+    size_t surfaceBytes() const override;
+
 private:
+    static constexpr int STAGING_MARGIN_TILES = 2;  // Min room added around the staging DIB when it grows
+
     HWND m_hwnd;
     HDC m_windowDC;
-    HDC m_memoryDC;
-    HBITMAP m_bitmap;
-    HBITMAP m_oldBitmap;
-    HBRUSH m_backgroundBrush;
-    HPEN m_pen;
     COLORREF m_trailColor;  // original RGB color
     BYTE m_alpha;           // user-specified alpha (0-255)
     float m_lineWidth;
@@ -59,14 +88,30 @@ private:
     LONG m_width;
     LONG m_height;
 
-    // Pointer to DIB bits (BGRA order)
-    void* m_pBits;
+    TrailCanvas m_canvas;  // The trail in premultiplied BGRA tiles
+
+    // Staging DIB presented with UpdateLayeredWindow; m_rcStaging is its tile-aligned area in surface pixels
+    HDC m_memoryDC;
+    HBITMAP m_bitmap;
+    HBITMAP m_oldBitmap;
+    uint32_t* m_pBits;
+    RECT m_rcStaging;
+    RECT m_rcWindow;  // Area the layered window was last sized to, in surface pixels
+
+    std::vector<TrailCanvas::Point> m_convertedPoints;  // Per-frame scratch, kept to avoid allocating
 
     COLORREF hexToCOLORREF(const std::string& hex);
     void computeVirtualScreenRect();
+    bool createSurface();
+    void releaseSurface();
+    bool ensureStaging(const RECT& needed);
+    void releaseStaging();
+    void stageTile(const TiledSurface::Tile& tile);
+    void unstageTile(int tx, int ty);
+    void present(const RECT* dirty);
 
-    // Draw smooth lines using Polyline instead of multiple LineTo calls
-    void drawSmoothTrail(const std::vector<POINT>& points);
+    // Copies the tiles the canvas last drew into the staging DIB and presents them
+    void presentDrawnTiles(bool dirtyOnly);
 
     // Disable copy and move
     GdiRenderer(const GdiRenderer&) = delete;
@@ -75,4 +120,4 @@ private:
     GdiRenderer& operator=(GdiRenderer&&) = delete;
 };
 
-}  // namespace VirtualDesktop
\ No newline at end of file
+}  // namespace VirtualDesktop
@@ -0,0 +1,311 @@
+#include "GestureKernels.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+
+namespace VirtualDesktop {
+
+namespace {
+
+// Number of points summed between checks of the early-abandon limit; a multiple of every vector width
+constexpr size_t ABANDON_BLOCK = 16;
+
+// Scalar kernels, also used for the tails of the SIMD loops
+double pathDistanceScalar(
+        const double* x1,
+        const double* y1,
+        const double* x2,
+        const double* y2,
+        size_t count,
+        double limit) {
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        double dx = x2[i] - x1[i];
+        double dy = y2[i] - y1[i];
+        sum += std::sqrt(dx * dx + dy * dy);
+        if ((i + 1) % ABANDON_BLOCK == 0 && sum > limit) {
+            return sum;
+        }
+    }
+    return sum;
+}
+
+void coordinateSumScalar(const double* x, const double* y, size_t count, double& sumX, double& sumY) {
+    sumX = 0.0;
+    sumY = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        sumX += x[i];
+        sumY += y[i];
+    }
+}
+
+void rotateScalar(
+        const double* x,
+        const double* y,
+        size_t count,
+        double cos,
+        double sin,
+        double cx,
+        double cy,
+        double* outX,
+        double* outY) {
+    for (size_t i = 0; i < count; i++) {
+        double dx = x[i] - cx;
+        double dy = y[i] - cy;
+        outX[i] = dx * cos - dy * sin + cx;
+        outY[i] = dx * sin + dy * cos + cy;
+    }
+}
+
+PathBounds boundsScalar(const double* x, const double* y, size_t count) {
+    PathBounds bounds = {x[0], y[0], x[0], y[0]};
+    for (size_t i = 1; i < count; i++) {
+        bounds.minX = std::min(bounds.minX, x[i]);
+        bounds.maxX = std::max(bounds.maxX, x[i]);
+        bounds.minY = std::min(bounds.minY, y[i]);
+        bounds.maxY = std::max(bounds.maxY, y[i]);
+    }
+    return bounds;
+}
+
+const GestureKernels SCALAR_KERNELS = {"scalar", pathDistanceScalar, coordinateSumScalar, rotateScalar, boundsScalar};
+
+#ifdef VDS_KERNELS_X86
+
+// SSE2 kernels, two doubles per register
+VDS_TARGET("sse2") double horizontalSum(__m128d v) {
+    return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+VDS_TARGET("sse2") double horizontalMin(__m128d v) {
+    return _mm_cvtsd_f64(_mm_min_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+VDS_TARGET("sse2") double horizontalMax(__m128d v) {
+    return _mm_cvtsd_f64(_mm_max_sd(v, _mm_unpackhi_pd(v, v)));
+}
+
+VDS_TARGET("sse2")
+double pathDistanceSse2(
+        const double* x1,
+        const double* y1,
+        const double* x2,
+        const double* y2,
+        size_t count,
+        double limit) {
+    __m128d sum = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(x2 + i), _mm_loadu_pd(x1 + i));
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(y2 + i), _mm_loadu_pd(y1 + i));
+        sum = _mm_add_pd(sum, _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy))));
+        if ((i + 2) % ABANDON_BLOCK == 0 && horizontalSum(sum) > limit) {
+            return horizontalSum(sum);
+        }
+    }
+    double head = horizontalSum(sum);
+    return head + pathDistanceScalar(x1 + i, y1 + i, x2 + i, y2 + i, count - i, limit - head);
+}
+
+VDS_TARGET("sse2") void coordinateSumSse2(const double* x, const double* y, size_t count, double& sumX, double& sumY) {
+    __m128d sx = _mm_setzero_pd();
+    __m128d sy = _mm_setzero_pd();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        sx = _mm_add_pd(sx, _mm_loadu_pd(x + i));
+        sy = _mm_add_pd(sy, _mm_loadu_pd(y + i));
+    }
+    coordinateSumScalar(x + i, y + i, count - i, sumX, sumY);
+    sumX += horizontalSum(sx);
+    sumY += horizontalSum(sy);
+}
+
+VDS_TARGET("sse2")
+void rotateSse2(
+        const double* x,
+        const double* y,
+        size_t count,
+        double cos,
+        double sin,
+        double cx,
+        double cy,
+        double* outX,
+        double* outY) {
+    const __m128d vcos = _mm_set1_pd(cos);
+    const __m128d vsin = _mm_set1_pd(sin);
+    const __m128d vcx = _mm_set1_pd(cx);
+    const __m128d vcy = _mm_set1_pd(cy);
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d dx = _mm_sub_pd(_mm_loadu_pd(x + i), vcx);
+        __m128d dy = _mm_sub_pd(_mm_loadu_pd(y + i), vcy);
+        __m128d qx = _mm_add_pd(_mm_sub_pd(_mm_mul_pd(dx, vcos), _mm_mul_pd(dy, vsin)), vcx);
+        __m128d qy = _mm_add_pd(_mm_add_pd(_mm_mul_pd(dx, vsin), _mm_mul_pd(dy, vcos)), vcy);
+        _mm_storeu_pd(outX + i, qx);
+        _mm_storeu_pd(outY + i, qy);
+    }
+    rotateScalar(x + i, y + i, count - i, cos, sin, cx, cy, outX + i, outY + i);
+}
+
+VDS_TARGET("sse2") PathBounds boundsSse2(const double* x, const double* y, size_t count) {
+    __m128d minX = _mm_set1_pd(x[0]);
+    __m128d maxX = minX;
+    __m128d minY = _mm_set1_pd(y[0]);
+    __m128d maxY = minY;
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d vx = _mm_loadu_pd(x + i);
+        __m128d vy = _mm_loadu_pd(y + i);
+        minX = _mm_min_pd(minX, vx);
+        maxX = _mm_max_pd(maxX, vx);
+        minY = _mm_min_pd(minY, vy);
+        maxY = _mm_max_pd(maxY, vy);
+    }
+    PathBounds bounds = {horizontalMin(minX), horizontalMin(minY), horizontalMax(maxX), horizontalMax(maxY)};
+    for (; i < count; i++) {
+        bounds.minX = std::min(bounds.minX, x[i]);
+        bounds.maxX = std::max(bounds.maxX, x[i]);
+        bounds.minY = std::min(bounds.minY, y[i]);
+        bounds.maxY = std::max(bounds.maxY, y[i]);
+    }
+    return bounds;
+}
+
+const GestureKernels SSE2_KERNELS = {"sse2", pathDistanceSse2, coordinateSumSse2, rotateSse2, boundsSse2};
+
+// AVX2 kernels, four doubles per register
+VDS_TARGET("avx2") __m128d foldHalves(__m256d v) {
+    return _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+}
+
+VDS_TARGET("avx2")
+double pathDistanceAvx2(
+        const double* x1,
+        const double* y1,
+        const double* x2,
+        const double* y2,
+        size_t count,
+        double limit) {
+    __m256d sum = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x2 + i), _mm256_loadu_pd(x1 + i));
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y2 + i), _mm256_loadu_pd(y1 + i));
+        sum = _mm256_add_pd(sum, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+        if ((i + 4) % ABANDON_BLOCK == 0 && horizontalSum(foldHalves(sum)) > limit) {
+            return horizontalSum(foldHalves(sum));
+        }
+    }
+    double head = horizontalSum(foldHalves(sum));
+    return head + pathDistanceScalar(x1 + i, y1 + i, x2 + i, y2 + i, count - i, limit - head);
+}
+
+VDS_TARGET("avx2") void coordinateSumAvx2(const double* x, const double* y, size_t count, double& sumX, double& sumY) {
+    __m256d sx = _mm256_setzero_pd();
+    __m256d sy = _mm256_setzero_pd();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        sx = _mm256_add_pd(sx, _mm256_loadu_pd(x + i));
+        sy = _mm256_add_pd(sy, _mm256_loadu_pd(y + i));
+    }
+    coordinateSumScalar(x + i, y + i, count - i, sumX, sumY);
+    sumX += horizontalSum(foldHalves(sx));
+    sumY += horizontalSum(foldHalves(sy));
+}
+
+VDS_TARGET("avx2")
+void rotateAvx2(
+        const double* x,
+        const double* y,
+        size_t count,
+        double cos,
+        double sin,
+        double cx,
+        double cy,
+        double* outX,
+        double* outY) {
+    const __m256d vcos = _mm256_set1_pd(cos);
+    const __m256d vsin = _mm256_set1_pd(sin);
+    const __m256d vcx = _mm256_set1_pd(cx);
+    const __m256d vcy = _mm256_set1_pd(cy);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(x + i), vcx);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(y + i), vcy);
+        __m256d qx = _mm256_add_pd(_mm256_sub_pd(_mm256_mul_pd(dx, vcos), _mm256_mul_pd(dy, vsin)), vcx);
+        __m256d qy = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(dx, vsin), _mm256_mul_pd(dy, vcos)), vcy);
+        _mm256_storeu_pd(outX + i, qx);
+        _mm256_storeu_pd(outY + i, qy);
+    }
+    rotateScalar(x + i, y + i, count - i, cos, sin, cx, cy, outX + i, outY + i);
+}
+
+VDS_TARGET("avx2") PathBounds boundsAvx2(const double* x, const double* y, size_t count) {
+    __m256d minX = _mm256_set1_pd(x[0]);
+    __m256d maxX = minX;
+    __m256d minY = _mm256_set1_pd(y[0]);
+    __m256d maxY = minY;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256d vx = _mm256_loadu_pd(x + i);
+        __m256d vy = _mm256_loadu_pd(y + i);
+        minX = _mm256_min_pd(minX, vx);
+        maxX = _mm256_max_pd(maxX, vx);
+        minY = _mm256_min_pd(minY, vy);
+        maxY = _mm256_max_pd(maxY, vy);
+    }
+    PathBounds bounds = {
+            horizontalMin(_mm_min_pd(_mm256_castpd256_pd128(minX), _mm256_extractf128_pd(minX, 1))),
+            horizontalMin(_mm_min_pd(_mm256_castpd256_pd128(minY), _mm256_extractf128_pd(minY, 1))),
+            horizontalMax(_mm_max_pd(_mm256_castpd256_pd128(maxX), _mm256_extractf128_pd(maxX, 1))),
+            horizontalMax(_mm_max_pd(_mm256_castpd256_pd128(maxY), _mm256_extractf128_pd(maxY, 1)))};
+    for (; i < count; i++) {
+        bounds.minX = std::min(bounds.minX, x[i]);
+        bounds.maxX = std::max(bounds.maxX, x[i]);
+        bounds.minY = std::min(bounds.minY, y[i]);
+        bounds.maxY = std::max(bounds.maxY, y[i]);
+    }
+    return bounds;
+}
+
+const GestureKernels AVX2_KERNELS = {"avx2", pathDistanceAvx2, coordinateSumAvx2, rotateAvx2, boundsAvx2};
+
+#endif  // VDS_KERNELS_X86
+
+const GestureKernels& selectGestureKernels() {
+#ifdef VDS_KERNELS_X86
+    if (cpuSupportsAvx2()) {
+        return AVX2_KERNELS;
+    }
+    if (cpuSupportsSse2()) {
+        return SSE2_KERNELS;
+    }
+#endif
+    return SCALAR_KERNELS;
+}
+
+}  // namespace
+
+const GestureKernels& gestureKernels() {
+    static const GestureKernels& selected = selectGestureKernels();
+    return selected;
+}
+
+const GestureKernels& scalarGestureKernels() {
+    return SCALAR_KERNELS;
+}
+
+std::vector<const GestureKernels*> supportedGestureKernels() {
+    std::vector<const GestureKernels*> kernels = {&SCALAR_KERNELS};
+#ifdef VDS_KERNELS_X86
+    if (cpuSupportsSse2()) {
+        kernels.push_back(&SSE2_KERNELS);
+    }
+    if (cpuSupportsAvx2()) {
+        kernels.push_back(&AVX2_KERNELS);
+    }
+#endif
+    return kernels;
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Bounding box of a gesture path
+ */
+struct PathBounds {
+    double minX;
+    double minY;
+    double maxX;
+    double maxY;
+};
+
+/**
+ * @brief Numeric kernels over structure-of-arrays gesture paths
+ *
+ * Every implementation computes the same values; the SIMD variants only differ from the scalar one by
+ * the order in which sums are accumulated, which keeps results within a relative error of 1e-12.
+ */
+struct GestureKernels {
+    const char* name;
+
+    // Sum of the distances between corresponding points of two paths. Once the running sum exceeds limit
+    // the remaining points are skipped and the partial sum, which is also above limit, is returned.
+    double (*pathDistance)(
+            const double* x1,
+            const double* y1,
+            const double* x2,
+            const double* y2,
+            size_t count,
+            double limit);
+
+    // Sum of the coordinates of a path; divide by count for the centroid
+    void (*coordinateSum)(const double* x, const double* y, size_t count, double& sumX, double& sumY);
+
+    // Rotates a path about (cx, cy), writing the result to outX/outY (which may alias x/y)
+    void (*rotate)(
+            const double* x,
+            const double* y,
+            size_t count,
+            double cos,
+            double sin,
+            double cx,
+            double cy,
+            double* outX,
+            double* outY);
+
+    // Bounding box of a non-empty path
+    PathBounds (*bounds)(const double* x, const double* y, size_t count);
+};
+
+/**
+ * @brief Returns the fastest kernels supported by the running CPU (AVX2, SSE2 or scalar)
+ */
+const GestureKernels& gestureKernels();
+
+/**
+ * @brief Returns the portable scalar kernels
+ */
+const GestureKernels& scalarGestureKernels();
+
+/**
+ * @brief Returns every kernel set the running CPU supports, from the scalar one to the fastest
+ */
+std::vector<const GestureKernels*> supportedGestureKernels();
+
+}  // namespace VirtualDesktop
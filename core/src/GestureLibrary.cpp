@@ -0,0 +1,182 @@
+#include "GestureLibrary.h"
+#ifdef _WIN32
+#include "utils.h"
+#endif
+#include <cstring>
+#include <type_traits>
+
+namespace VirtualDesktop {
+
+GestureLibrary::~GestureLibrary() {
+    close();
+}
+
+void GestureLibrary::assign(const GestureAnalyzer::GestureTemplate* templates, size_t count) {
+    close();
+    m_filePath.clear();
+    m_templates = templates;
+    m_count = count;
+}
+
+#ifdef _WIN32
+namespace {
+constexpr char LIBRARY_MAGIC[4] = {'V', 'D', 'S', 'G'};
+
+// File header; records follow it directly, and its size keeps them aligned for the recognizer kernels
+struct alignas(32) LibraryHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t recordSize;     // sizeof(GestureTemplate) when the file was written
+    uint32_t pathCapacity;   // GesturePath::CAPACITY when the file was written
+    uint32_t templateCount;  // Number of complete records
+};
+
+using GestureTemplate = GestureAnalyzer::GestureTemplate;
+
+static_assert(std::is_trivially_copyable<GestureTemplate>::value, "Templates are stored as raw bytes");
+static_assert(sizeof(LibraryHeader) % alignof(GestureTemplate) == 0, "Records must stay aligned after the header");
+
+LibraryHeader makeHeader(uint32_t templateCount) {
+    LibraryHeader header{};
+    std::memcpy(header.magic, LIBRARY_MAGIC, sizeof(LIBRARY_MAGIC));
+    header.version = GestureLibrary::FORMAT_VERSION;
+    header.recordSize = static_cast<uint32_t>(sizeof(GestureTemplate));
+    header.pathCapacity = static_cast<uint32_t>(GesturePath::CAPACITY);
+    header.templateCount = templateCount;
+    return header;
+}
+
+bool isCompatible(const LibraryHeader& header) {
+    LibraryHeader expected = makeHeader(header.templateCount);
+    return std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.version == expected.version &&
+           header.recordSize == expected.recordSize && header.pathCapacity == expected.pathCapacity;
+}
+
+bool writeAt(HANDLE file, LONGLONG offset, const void* data, DWORD size) {
+    LARGE_INTEGER position;
+    position.QuadPart = offset;
+    DWORD written = 0;
+    return SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && WriteFile(file, data, size, &written, nullptr) &&
+           written == size;
+}
+}  // namespace
+
+bool GestureLibrary::load(const std::wstring& filePath) {
+    close();
+    m_filePath = filePath;
+
+    HANDLE file = CreateFileW(
+            filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    m_file = file;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_file, &fileSize) || fileSize.QuadPart < static_cast<LONGLONG>(sizeof(LibraryHeader))) {
+        trace("Gesture library %ls is empty or unreadable", filePath.c_str());
+        close();
+        return false;
+    }
+
+    // Map the whole file read-only; the OS pages records in on demand and shares them with the file cache
+    m_mapping = CreateFileMappingW(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (m_mapping) {
+        m_view = MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!m_view) {
+        trace("Failed to map gesture library %ls, error: %lu", filePath.c_str(), GetLastError());
+        close();
+        return false;
+    }
+
+    const auto* header = static_cast<const LibraryHeader*>(m_view);
+    LONGLONG available = (fileSize.QuadPart - static_cast<LONGLONG>(sizeof(LibraryHeader))) /
+                         static_cast<LONGLONG>(sizeof(GestureTemplate));
+    if (!isCompatible(*header) || header->templateCount > available) {
+        trace("Ignoring gesture library %ls with an unsupported format", filePath.c_str());
+        close();
+        return false;
+    }
+
+    m_templates = reinterpret_cast<const GestureTemplate*>(static_cast<const char*>(m_view) + sizeof(LibraryHeader));
+    m_count = header->templateCount;
+    trace("Mapped %zu gesture templates from %ls", m_count, filePath.c_str());
+    return true;
+}
+
+bool GestureLibrary::add(const GestureAnalyzer::GestureTemplate& gestureTemplate) {
+    if (m_filePath.empty()) {
+        return false;
+    }
+
+    // The file cannot be written while it is mapped
+    const bool hasLibrary = (m_view != nullptr);
+    const uint32_t count = static_cast<uint32_t>(m_count);
+    close();
+
+    HANDLE file = CreateFileW(
+            m_filePath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        trace("Failed to open gesture library %ls for writing, error: %lu", m_filePath.c_str(), GetLastError());
+        load(m_filePath);
+        return false;
+    }
+
+    bool written = true;
+    if (!hasLibrary) {
+        // Replace a missing or incompatible file with an empty library
+        LibraryHeader header = makeHeader(0);
+        written = writeAt(file, 0, &header, sizeof(header)) && SetEndOfFile(file);
+    }
+
+    // Write the record before the count that makes it visible, so an interrupted write leaves a valid file
+    LibraryHeader header = makeHeader(count + 1);
+    LONGLONG offset = static_cast<LONGLONG>(sizeof(LibraryHeader)) +
+                      static_cast<LONGLONG>(count) * static_cast<LONGLONG>(sizeof(GestureTemplate));
+    written = written && writeAt(file, offset, &gestureTemplate, sizeof(gestureTemplate)) &&
+              writeAt(file, 0, &header, sizeof(header));
+    CloseHandle(file);
+
+    if (!written) {
+        trace("Failed to write gesture library %ls", m_filePath.c_str());
+    }
+    load(m_filePath);
+    return written;
+}
+
+void GestureLibrary::close() {
+    if (m_view) {
+        UnmapViewOfFile(m_view);
+        m_view = nullptr;
+    }
+    if (m_mapping) {
+        CloseHandle(m_mapping);
+        m_mapping = nullptr;
+    }
+    if (m_file) {
+        CloseHandle(m_file);
+        m_file = nullptr;
+    }
+    m_templates = nullptr;
+    m_count = 0;
+}
+#else
+// Library files are mapped with Win32; elsewhere, such as in the benchmarks and tests, only assign() is supported
+bool GestureLibrary::load(const std::wstring& filePath) {
+    close();
+    m_filePath = filePath;
+    return false;
+}
+
+bool GestureLibrary::add(const GestureAnalyzer::GestureTemplate& /*gestureTemplate*/) {
+    return false;
+}
+
+void GestureLibrary::close() {
+    m_templates = nullptr;
+    m_count = 0;
+}
+#endif
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,175 @@
+#include "HeadlessRenderer.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace VirtualDesktop {
+
+namespace {
+constexpr uint32_t DEFAULT_TRAIL_COLOR = 0x6495ED;  // Cornflower Blue
+
+int64_t nowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+}
+
+void addStats(FrameStats& total, const FrameStats& frame) {
+    total.nanoseconds += frame.nanoseconds;
+    total.tilesDrawn += frame.tilesDrawn;
+    total.pixelsTouched += frame.pixelsTouched;
+    total.bytesPresented += frame.bytesPresented;
+}
+}  // namespace
+
+HeadlessRenderer::HeadlessRenderer() :
+        m_color(DEFAULT_TRAIL_COLOR),
+        m_alpha(0xAA),
+        m_left(0),
+        m_top(0),
+        m_width(0),
+        m_height(0),
+        m_lastFrame{},
+        m_totals{},
+        m_frames(0) {
+}
+
+void HeadlessRenderer::setTrailStyle(const std::string& colorHex, float lineWidth) {
+    // Same rules as GdiRenderer: a malformed color falls back to the default and keeps the alpha
+    m_color = DEFAULT_TRAIL_COLOR;
+    if (colorHex.size() == 9 && colorHex[0] == '#' &&
+        std::all_of(colorHex.begin() + 1, colorHex.end(), [](char c) {
+            return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+        })) {
+        uint32_t rgba = static_cast<uint32_t>(std::stoul(colorHex.substr(1), nullptr, 16));
+        m_color = rgba >> 8;
+        m_alpha = static_cast<uint8_t>(rgba & 0xFF);
+    }
+    m_canvas.setStyle(m_color, m_alpha, std::clamp(lineWidth, 1.0f, 10.0f));
+}
+
+void HeadlessRenderer::setThreads(unsigned threads) {
+    m_canvas.setThreads(threads);
+}
+
+void HeadlessRenderer::setScreen(int left, int top, int width, int height) {
+    m_left = left;
+    m_top = top;
+    m_width = std::max(width, 1);
+    m_height = std::max(height, 1);
+    m_canvas.resize(m_width, m_height);
+    std::vector<uint32_t>().swap(m_framebuffer);
+}
+
+bool HeadlessRenderer::prepare() {
+    if (!m_framebuffer.empty()) {
+        return true;
+    }
+    try {
+        m_framebuffer.assign(static_cast<size_t>(m_width) * static_cast<size_t>(m_height), 0);
+    } catch (const std::bad_alloc&) {
+        return false;
+    }
+    return true;
+}
+
+void HeadlessRenderer::trim() {
+    m_canvas.release();
+    std::vector<uint32_t>().swap(m_framebuffer);
+}
+
+size_t HeadlessRenderer::surfaceBytes() const {
+    return m_canvas.bytes() + m_framebuffer.size() * sizeof(uint32_t);
+}
+
+void HeadlessRenderer::resetStats() {
+    m_lastFrame = {};
+    m_totals = {};
+    m_frames = 0;
+}
+
+uint64_t HeadlessRenderer::presentTile(int tx, int ty, const uint32_t* pixels) {
+    // Tiles on the right and bottom edges stick out of the framebuffer
+    const int x = tx * TiledSurface::TILE_SIZE;
+    const int y = ty * TiledSurface::TILE_SIZE;
+    const size_t columns = static_cast<size_t>(std::min(TiledSurface::TILE_SIZE, m_width - x));
+    const int rows = std::min(TiledSurface::TILE_SIZE, m_height - y);
+    uint32_t* dst = m_framebuffer.data() + static_cast<size_t>(y) * m_width + x;
+    for (int row = 0; row < rows; ++row) {
+        if (pixels) {
+            memcpy(dst + static_cast<size_t>(row) * m_width,
+                   pixels + row * TiledSurface::TILE_SIZE,
+                   columns * sizeof(uint32_t));
+        } else {
+            memset(dst + static_cast<size_t>(row) * m_width, 0, columns * sizeof(uint32_t));
+        }
+    }
+    return static_cast<uint64_t>(rows) * columns * sizeof(uint32_t);
+}
+
+void HeadlessRenderer::present(FrameStats& frame) {
+    for (const TiledSurface::Tile& tile : m_canvas.erasedTiles()) {
+        frame.bytesPresented += presentTile(tile.tx, tile.ty, nullptr);
+    }
+    for (const TiledSurface::Tile& tile : m_canvas.drawnTiles()) {
+        frame.bytesPresented += presentTile(tile.tx, tile.ty, tile.pixels);
+    }
+    frame.tilesDrawn = m_canvas.drawnTiles().size();
+    frame.pixelsTouched = frame.tilesDrawn * TiledSurface::TILE_PIXELS;
+}
+
+void HeadlessRenderer::record(FrameStats& frame, int64_t start) {
+    frame.nanoseconds = static_cast<uint64_t>(nowNanoseconds() - start);
+    m_lastFrame = frame;
+    addStats(m_totals, frame);
+    ++m_frames;
+}
+
+void HeadlessRenderer::render(const TrailCanvas::Point* points, size_t count) {
+    if (count == 0 || !prepare()) {
+        return;
+    }
+
+    const int64_t start = nowNanoseconds();
+    m_convertedPoints.clear();
+    for (size_t i = 0; i < count; ++i) {
+        m_convertedPoints.push_back({points[i].x - m_left, points[i].y - m_top});
+    }
+    m_canvas.render(m_convertedPoints.data(), m_convertedPoints.size());
+
+    FrameStats frame = {};
+    present(frame);
+    record(frame, start);
+}
+
+void HeadlessRenderer::append(TrailCanvas::Point point) {
+    // Without a framebuffer the point still becomes the start of the next segment
+    const int64_t start = nowNanoseconds();
+    bool ready = prepare();
+    m_canvas.append({point.x - m_left, point.y - m_top});
+    if (!ready) {
+        return;
+    }
+
+    FrameStats frame = {};
+    present(frame);
+    record(frame, start);
+}
+
+void HeadlessRenderer::clear() {
+    if (m_framebuffer.empty()) {
+        m_canvas.clear();
+        return;
+    }
+
+    const int64_t start = nowNanoseconds();
+    FrameStats frame = {};
+    for (const TiledSurface::Tile& tile : m_canvas.surface().tiles()) {
+        frame.bytesPresented += presentTile(tile.tx, tile.ty, nullptr);
+    }
+    m_canvas.clear();
+    record(frame, start);
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,133 @@
+#pragma once
+#include "TrailCanvas.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief What one render(), append() or clear() call of the headless renderer cost
+ */
+struct FrameStats {
+    uint64_t nanoseconds;     // Time spent drawing and presenting
+    uint64_t tilesDrawn;      // Trail tiles drawn
+    uint64_t pixelsTouched;   // Pixels of the tiles drawn
+    uint64_t bytesPresented;  // Bytes written into the framebuffer, copied or cleared
+};
+
+/**
+ * @brief Platform-independent renderer that presents the trail into a plain memory framebuffer
+ *
+ * Draws like GdiRenderer, through a TrailCanvas, but presents by copying the drawn tiles into a framebuffer of
+ * premultiplied BGRA covering the virtual screen instead of a layered window. It makes no platform calls, so
+ * the trail pipeline can run, be measured and be compared image by image on any machine. Every call that draws
+ * records its FrameStats. The framebuffer is allocated by prepare() and freed by trim(), like a real surface.
+ */
+class HeadlessRenderer {
+public:
+    HeadlessRenderer();
+    HeadlessRenderer(const HeadlessRenderer&) = delete;
+    HeadlessRenderer& operator=(const HeadlessRenderer&) = delete;
+
+    /**
+     * @brief Sets the trail style (color and line width)
+     * @param colorHex Color in hex format (#RRGGBBAA)
+     * @param lineWidth Width of the trail line, clamped to 1-10
+     */
+    void setTrailStyle(const std::string& colorHex, float lineWidth);
+
+    /**
+     * @brief Sets the threads that draw tiles; see TrailCanvas::setThreads()
+     */
+    void setThreads(unsigned threads);
+
+    /**
+     * @brief Sets the virtual screen in screen coordinates, dropping the trail and the framebuffer
+     */
+    void setScreen(int left, int top, int width, int height);
+
+    /**
+     * @brief Redraws the trail through points in screen coordinates and presents it
+     */
+    void render(const TrailCanvas::Point* points, size_t count);
+
+    /**
+     * @brief Extends the trail to a new point in screen coordinates and presents the tiles it touched
+     */
+    void append(TrailCanvas::Point point);
+
+    /**
+     * @brief Clears the trail and the framebuffer
+     */
+    void clear();
+
+    /**
+     * @brief Allocates the framebuffer if it is not allocated yet
+     * @return true if the renderer can draw
+     */
+    bool prepare();
+
+    /**
+     * @brief Releases the tile pool and the framebuffer
+     */
+    void trim();
+
+    /**
+     * @brief Returns the bytes held by the tile pool and the framebuffer
+     */
+    size_t surfaceBytes() const;
+
+    int width() const {
+        return m_width;
+    }
+
+    int height() const {
+        return m_height;
+    }
+
+    // Presented image, width() * height() pixels of premultiplied BGRA; nullptr until prepare()
+    const uint32_t* framebuffer() const {
+        return m_framebuffer.empty() ? nullptr : m_framebuffer.data();
+    }
+
+    // Cost of the last call that drew or cleared
+    const FrameStats& lastFrame() const {
+        return m_lastFrame;
+    }
+
+    // Sum over all frames since the last resetStats()
+    const FrameStats& totals() const {
+        return m_totals;
+    }
+
+    uint64_t frames() const {
+        return m_frames;
+    }
+
+    void resetStats();
+
+private:
+    // Copies the tiles the canvas last drew into the framebuffer and clears the ones it erased
+    void present(FrameStats& frame);
+    // Copies a tile into the framebuffer, or clears its area if pixels is nullptr; returns the bytes written
+    uint64_t presentTile(int tx, int ty, const uint32_t* pixels);
+    void record(FrameStats& frame, int64_t start);
+
+    TrailCanvas m_canvas;
+    uint32_t m_color;  // 0x00RRGGBB
+    uint8_t m_alpha;
+    int m_left;
+    int m_top;
+    int m_width;
+    int m_height;
+    std::vector<uint32_t> m_framebuffer;
+    std::vector<TrailCanvas::Point> m_convertedPoints;  // Per-frame scratch, kept to avoid allocating
+
+    FrameStats m_lastFrame;
+    FrameStats m_totals;
+    uint64_t m_frames;
+};
+
+}  // namespace VirtualDesktop
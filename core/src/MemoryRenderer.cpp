@@ -0,0 +1,50 @@
+#include "MemoryRenderer.h"
+
+namespace VirtualDesktop {
+
+void MemoryRenderer::setTrailStyle(const std::string& colorHex, float lineWidth) {
+    m_headless.setTrailStyle(colorHex, lineWidth);
+}
+
+bool MemoryRenderer::initialize(HWND) {
+    resizeForMonitors();
+    return true;
+}
+
+void MemoryRenderer::resizeForMonitors() {
+    m_headless.setScreen(
+            GetSystemMetrics(SM_XVIRTUALSCREEN),
+            GetSystemMetrics(SM_YVIRTUALSCREEN),
+            GetSystemMetrics(SM_CXVIRTUALSCREEN),
+            GetSystemMetrics(SM_CYVIRTUALSCREEN));
+}
+
+void MemoryRenderer::render(const std::vector<POINT>& points) {
+    m_points.clear();
+    for (const auto& pt : points) {
+        m_points.push_back({static_cast<int32_t>(pt.x), static_cast<int32_t>(pt.y)});
+    }
+    m_headless.render(m_points.data(), m_points.size());
+}
+
+void MemoryRenderer::append(const POINT& point) {
+    m_headless.append({static_cast<int32_t>(point.x), static_cast<int32_t>(point.y)});
+}
+
+void MemoryRenderer::clear() {
+    m_headless.clear();
+}
+
+bool MemoryRenderer::prepare() {
+    return m_headless.prepare();
+}
+
+void MemoryRenderer::trim() {
+    m_headless.trim();
+}
+
+size_t MemoryRenderer::surfaceBytes() const {
+    return m_headless.surfaceBytes();
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,51 @@
+#pragma once
+#include "HeadlessRenderer.h"
+#include "IRenderer.h"
+#include <Windows.h>
+#include <string>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief IRenderer adapter over HeadlessRenderer, drawing into memory instead of the overlay window
+ *
+ * Selected with the "Memory" rendering mode, it runs the whole trail pipeline of OverlayUI without showing
+ * anything, for measuring and testing. Its only Win32 use is reading the virtual screen bounds.
+ */
+class MemoryRenderer : public IRenderer {
+public:
+    MemoryRenderer() = default;
+
+    void setTrailStyle(const std::string& colorHex, float lineWidth) override;
+
+    /**
+     * @brief Sizes the framebuffer for the virtual screen; the window is not drawn into
+     */
+    bool initialize(HWND hwndParent) override;
+
+    void resizeForMonitors() override;
+    void render(const std::vector<POINT>& points) override;
+    void append(const POINT& point) override;
+    void clear() override;
+    bool prepare() override;
+    void trim() override;
+    size_t surfaceBytes() const override;
+
+    // The renderer doing the work, with the framebuffer and the frame statistics
+    const HeadlessRenderer& headless() const {
+        return m_headless;
+    }
+
+private:
+    HeadlessRenderer m_headless;
+    std::vector<TrailCanvas::Point> m_points;  // Per-frame scratch, kept to avoid allocating
+
+    // Disable copy and move
+    MemoryRenderer(const MemoryRenderer&) = delete;
+    MemoryRenderer& operator=(const MemoryRenderer&) = delete;
+    MemoryRenderer(MemoryRenderer&&) = delete;
+    MemoryRenderer& operator=(MemoryRenderer&&) = delete;
+};
+
+}  // namespace VirtualDesktop
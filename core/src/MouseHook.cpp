@@ -1,5 +1,7 @@
 #include "MouseHook.h"
+#include "utils.h"
 #include <stdexcept>
+#include <utility>
 
 namespace VirtualDesktop {
 
@@ -8,13 +10,32 @@ MouseHook& MouseHook::getInstance() {
     return instance;
 }
 
+MouseHook::~MouseHook() {
+    // Waiting for the worker here could deadlock under the loader lock at process exit; shutdown() does it
+    if (m_worker != nullptr) {
+        CloseHandle(m_worker);
+    }
+}
+
 bool MouseHook::initialize() {
     if (m_hook != nullptr) {
         return true;
     }
 
+    m_wakeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (m_wakeEvent == nullptr) {
+        throw std::runtime_error("Failed to create mouse event queue");
+    }
+    m_running.store(true);
+    m_worker = CreateThread(nullptr, 0, workerProc, this, 0, nullptr);
+    if (m_worker == nullptr) {
+        shutdown();
+        throw std::runtime_error("Failed to start mouse event worker");
+    }
+
     m_hook = SetWindowsHookEx(WH_MOUSE_LL, hookCallback, nullptr, 0);
     if (m_hook == nullptr) {
+        shutdown();
         throw std::runtime_error("Failed to set mouse hook");
     }
     return true;
@@ -25,25 +46,188 @@ void MouseHook::shutdown() {
         UnhookWindowsHookEx(m_hook);
         m_hook = nullptr;
     }
+    m_armed.store(false);
+
+    m_running.store(false);
+    if (m_worker != nullptr) {
+        SetEvent(m_wakeEvent);
+        // Callbacks may send messages to windows of this thread, so keep serving them until the worker exits
+        while (MsgWaitForMultipleObjects(1, &m_worker, FALSE, INFINITE, QS_SENDMESSAGE) == WAIT_OBJECT_0 + 1) {
+            MSG msg;
+            PeekMessage(&msg, nullptr, 0, 0, PM_NOREMOVE | PM_QS_SENDMESSAGE);
+        }
+        CloseHandle(m_worker);
+        m_worker = nullptr;
+    }
+    if (m_wakeEvent != nullptr) {
+        CloseHandle(m_wakeEvent);
+        m_wakeEvent = nullptr;
+    }
+
+    uint32_t dropped = m_queue.takeDroppedEvents();
+    if (dropped > 0) {
+        trace("Mouse event queue overflowed, %u events dropped", dropped);
+    }
     removeCallbacks();
 }
 
-void MouseHook::addCallback(const EventCallback& callback) {
-    m_callbacks.push_back(callback);
+void MouseHook::setTrigger(uint32_t downMessage, uint16_t xButton) {
+    m_nextTrigger.store(downMessage == 0 ? 0 : (downMessage & 0xFFFF) | (static_cast<uint32_t>(xButton) << 16));
+}
+
+MouseHook::CallbackId MouseHook::addCallback(const EventCallback& callback, uint32_t mask) {
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    auto callbacks = m_callbacks ? std::make_shared<CallbackList>(*m_callbacks) : std::make_shared<CallbackList>();
+    CallbackId id = m_nextCallbackId++;
+    callbacks->push_back({id, mask & AllEvents, callback});
+    publishCallbacks(std::move(callbacks));
+    return id;
+}
+
+void MouseHook::removeCallback(CallbackId id) {
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    if (!m_callbacks) {
+        return;
+    }
+    auto callbacks = std::make_shared<CallbackList>();
+    callbacks->reserve(m_callbacks->size());
+    for (const auto& subscription : *m_callbacks) {
+        if (subscription.id != id) {
+            callbacks->push_back(subscription);
+        }
+    }
+    publishCallbacks(std::move(callbacks));
 }
 
 void MouseHook::removeCallbacks() {
-    m_callbacks.clear();
+    std::lock_guard<std::mutex> lock(m_callbacksMutex);
+    publishCallbacks(nullptr);
+}
+
+void MouseHook::publishCallbacks(std::shared_ptr<const CallbackList> callbacks) {
+    uint32_t mask = 0;
+    if (callbacks) {
+        for (const auto& subscription : *callbacks) {
+            mask |= subscription.mask;
+        }
+    }
+    std::atomic_store(&m_callbacks, std::move(callbacks));
+    m_subscribedMask.store(mask);
 }
 
 LRESULT CALLBACK MouseHook::hookCallback(int nCode, WPARAM wParam, LPARAM lParam) {
     if (nCode >= HC_ACTION) {
         auto& instance = getInstance();
-        for (const auto& callback : instance.m_callbacks) {
-            callback(nCode, wParam, lParam);
+        const auto* mouseData = reinterpret_cast<const MSLLHOOKSTRUCT*>(lParam);
+        uint32_t kind;
+        if (wParam == WM_MOUSEMOVE) {
+            // Fast path: an idle move nobody listens to costs two loads and a branch
+            kind = instance.m_armed.load(std::memory_order_relaxed) ? ArmedMove : IdleMove;
+        } else {
+            kind = instance.classifyButton(static_cast<uint32_t>(wParam), mouseData->mouseData);
+        }
+        if ((instance.m_subscribedMask.load(std::memory_order_relaxed) & kind) != 0) {
+            MouseEvent event;
+            event.message = static_cast<uint32_t>(wParam);
+            event.x = mouseData->pt.x;
+            event.y = mouseData->pt.y;
+            event.mouseData = mouseData->mouseData;
+            event.time = mouseData->time;
+            instance.enqueue(event, kind);
         }
     }
     return CallNextHookEx(nullptr, nCode, wParam, lParam);
 }
 
-}  // namespace VirtualDesktop
\ No newline at end of file
+uint32_t MouseHook::classifyButton(uint32_t message, uint32_t mouseData) {
+    switch (message) {
+        case WM_MOUSEWHEEL:
+        case WM_MOUSEHWHEEL:
+            return Wheel;
+        case WM_LBUTTONDOWN:
+        case WM_RBUTTONDOWN:
+        case WM_MBUTTONDOWN:
+        case WM_XBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_RBUTTONUP:
+        case WM_MBUTTONUP:
+        case WM_XBUTTONUP:
+            break;
+        default:
+            return 0;
+    }
+
+    // Between gestures, take the trigger last set; during one, keep the button that started it until its release
+    if (!m_armed.load(std::memory_order_relaxed)) {
+        m_trigger = m_nextTrigger.load(std::memory_order_relaxed);
+    }
+
+    // Every button's up message directly follows its down message
+    uint32_t trigger = m_trigger;
+    uint32_t downMessage = trigger & 0xFFFF;
+    bool isDown = message == downMessage;
+    if (downMessage == 0 || (!isDown && message != downMessage + 1) ||
+        (downMessage == WM_XBUTTONDOWN && HIWORD(mouseData) != (trigger >> 16))) {
+        return OtherButtons;
+    }
+    m_armed.store(isDown, std::memory_order_relaxed);
+    return TriggerButton;
+}
+
+void MouseHook::enqueue(const MouseEvent& event, uint32_t kind) {
+    const MouseEventQueue::Item item = {event, kind};
+    if (kind != TriggerButton) {
+        if (!m_queue.pushEvent(item)) {
+            return;
+        }
+    } else if (m_armed.load(std::memory_order_relaxed)) {
+        // classifyButton() armed the hook for this press; if the worker cannot get it, the click never happened
+        if (!m_queue.pushPress(item)) {
+            m_armed.store(false, std::memory_order_relaxed);
+            return;
+        }
+    } else if (!m_queue.pushRelease(item)) {
+        return;
+    }
+    // Pairs with the fence in workerLoop(): either the worker sees the event or this thread sees it idle
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_workerIdle.load(std::memory_order_relaxed)) {
+        SetEvent(m_wakeEvent);
+    }
+}
+
+DWORD WINAPI MouseHook::workerProc(LPVOID param) {
+    static_cast<MouseHook*>(param)->workerLoop();
+    return 0;
+}
+
+void MouseHook::workerLoop() {
+    MouseEventQueue::Item queued;
+    for (;;) {
+        while (m_queue.tryPop(queued)) {
+            // Hold the current list for this event; callbacks may add or remove callbacks meanwhile
+            std::shared_ptr<const CallbackList> callbacks = std::atomic_load(&m_callbacks);
+            if (!callbacks) {
+                continue;
+            }
+            for (const auto& subscription : *callbacks) {
+                if ((subscription.mask & queued.kind) != 0) {
+                    subscription.callback(queued.event);
+                }
+            }
+        }
+        if (!m_running.load()) {
+            break;
+        }
+
+        // Announce the wait before checking the queue one last time, so a concurrent push always wakes us
+        m_workerIdle.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_queue.empty() && m_running.load()) {
+            WaitForSingleObject(m_wakeEvent, INFINITE);
+        }
+        m_workerIdle.store(false, std::memory_order_relaxed);
+    }
+}
+
+}  // namespace VirtualDesktop
@@ -3,6 +3,7 @@
 #include "IRenderer.h"
 #include "utils.h"
 #include <string.h>
+#include <algorithm>
 #include <cmath>
 
 namespace VirtualDesktop {
@@ -90,11 +91,6 @@ void OverlayUI::switchRenderer() {
         return;
     }
 
-    // If there is an existing renderer, clear it before switching
-    if (m_renderer) {
-        m_renderer->clear();
-    }
-
     // Apply settings to new renderer
     std::string colorHex = m_settings->getOverlayColor();
     float lineWidth = static_cast<float>(m_settings->getGestureLineWidth());
@@ -110,20 +106,50 @@ void OverlayUI::switchRenderer() {
         newRenderer->initialize(m_hWnd);
     }
 
+    // If there is an existing renderer, clear it before switching
+    std::lock_guard<std::mutex> lock(m_rendererMutex);
+    if (m_renderer) {
+        m_renderer->clear();
+    }
     m_renderer = std::move(newRenderer);
+    m_surfaceBytes.store(0);  // The new renderer allocates its surface at the next gesture
 }
 
 void OverlayUI::setSettings(const Settings& settings) {
     m_settings = &settings;
+    m_trajectoryPoints.setLimits(settings.getStrokeCapacity(), settings.getStrokeDecimationRadius());
+    // Smoothing adds up to four points per segment, so the smoothed trail never reallocates either
+    m_smoothedPoints.reserve(m_trajectoryPoints.capacity() * 5);
+    m_trimDelayMs.store(static_cast<UINT>(std::max(settings.getSurfaceTrimDelay(), 0)) * 1000);
+    m_incrementalTrail = settings.isIncrementalTrailEnabled();
     switchRenderer();  // Switch renderer based on new settings
 }
 
 void OverlayUI::clear() {
+    std::lock_guard<std::mutex> lock(m_rendererMutex);
     if (m_renderer) {
         m_renderer->clear();
     }
 }
 
+size_t OverlayUI::surfaceBytes() const {
+    return m_surfaceBytes.load();
+}
+
+void OverlayUI::trimIfIdle() {
+    // Never wait for the worker here: it may be inside a window call that waits for this thread
+    std::unique_lock<std::mutex> lock(m_rendererMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        SetTimer(m_hWnd, TRIM_TIMER_ID, 1000, nullptr);  // Try again shortly
+        return;
+    }
+    if (!m_visible && m_renderer) {
+        m_renderer->trim();
+        m_surfaceBytes.store(m_renderer->surfaceBytes());
+        trace("Overlay surface trimmed");
+    }
+}
+
 LRESULT OverlayUI::windowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam) {
     if (message == WM_CREATE) {
         // Store the OverlayUI instance in window user data
@@ -137,8 +163,33 @@ LRESULT OverlayUI::windowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPa
         switch (message) {
             case WM_DISPLAYCHANGE:
             case WM_SETTINGCHANGE: {
-                if (pOverlay && pOverlay->m_renderer) {
-                    pOverlay->m_renderer->resizeForMonitors();
+                if (pOverlay) {
+                    // Resize now if the worker is not drawing, otherwise when the next gesture is shown
+                    std::unique_lock<std::mutex> lock(pOverlay->m_rendererMutex, std::try_to_lock);
+                    if (lock.owns_lock() && pOverlay->m_renderer) {
+                        pOverlay->m_renderer->resizeForMonitors();
+                        pOverlay->m_surfaceBytes.store(pOverlay->m_renderer->surfaceBytes());
+                        pOverlay->m_redrawPending.store(true);  // Resizing dropped the trail drawn so far
+                    } else if (!lock.owns_lock()) {
+                        pOverlay->m_resizePending.store(true);
+                    }
+                }
+                break;
+            }
+            case WM_OVERLAY_HIDDEN: {
+                UINT delay = pOverlay ? pOverlay->m_trimDelayMs.load() : 0;
+                if (delay > 0) {
+                    SetTimer(hWnd, TRIM_TIMER_ID, delay, nullptr);  // Restarts a pending timer
+                }
+                return 0;
+            }
+            case WM_TIMER: {
+                if (wParam == TRIM_TIMER_ID) {
+                    KillTimer(hWnd, TRIM_TIMER_ID);
+                    if (pOverlay) {
+                        pOverlay->trimIfIdle();
+                    }
+                    return 0;
                 }
                 break;
             }
@@ -151,6 +202,18 @@ LRESULT OverlayUI::windowProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPa
 
 void OverlayUI::show() {
     if (m_hWnd != nullptr) {
+        {
+            // Allocate the surface up front, so the first trail segment is not delayed by it
+            std::lock_guard<std::mutex> lock(m_rendererMutex);
+            m_visible = true;
+            if (m_renderer) {
+                if (m_resizePending.exchange(false)) {
+                    m_renderer->resizeForMonitors();
+                }
+                m_renderer->prepare();
+                m_surfaceBytes.store(m_renderer->surfaceBytes());
+            }
+        }
         ShowWindow(m_hWnd, SW_SHOW);
         UpdateWindow(m_hWnd);
     }
@@ -162,13 +225,21 @@ void OverlayUI::hide() {
         // Clear trajectory points when hiding
         m_trajectoryPoints.clear();
         // Clear the overlay display
-        clear();
+        {
+            std::lock_guard<std::mutex> lock(m_rendererMutex);
+            m_visible = false;
+            if (m_renderer) {
+                m_renderer->clear();
+            }
+        }
+        // Release the surface once the overlay stayed hidden for the trim delay
+        PostMessage(m_hWnd, WM_OVERLAY_HIDDEN, 0, 0);
     }
 }
 
 void OverlayUI::smoothTrajectory() {
     if (m_trajectoryPoints.size() < 2) {
-        m_smoothedPoints = m_trajectoryPoints;  // Not enough points to smooth
+        m_smoothedPoints = m_trajectoryPoints.points();  // Not enough points to smooth
         return;
     }
 
@@ -176,7 +247,7 @@ void OverlayUI::smoothTrajectory() {
 
     // For small number of points, just use original points
     if (m_trajectoryPoints.size() < 3) {
-        m_smoothedPoints = m_trajectoryPoints;
+        m_smoothedPoints = m_trajectoryPoints.points();
         return;
     }
 
@@ -184,11 +255,12 @@ void OverlayUI::smoothTrajectory() {
     // This helps make the line appear more continuous
 
     // Copy the first point
-    m_smoothedPoints.push_back(m_trajectoryPoints[0]);
+    const std::vector<POINT>& trajectory = m_trajectoryPoints.points();
+    m_smoothedPoints.push_back(trajectory[0]);
 
-    for (size_t i = 1; i < m_trajectoryPoints.size(); ++i) {
-        const POINT& prevPt = m_trajectoryPoints[i - 1];
-        const POINT& currPt = m_trajectoryPoints[i];
+    for (size_t i = 1; i < trajectory.size(); ++i) {
+        const POINT& prevPt = trajectory[i - 1];
+        const POINT& currPt = trajectory[i];
 
         // Calculate distance between points
         int dx = currPt.x - prevPt.x;
@@ -218,11 +290,22 @@ void OverlayUI::updatePosition(int x, int y) {
         return;
     }
 
-    // Add new point to trajectory
-    POINT newPoint = {x, y};
-    m_trajectoryPoints.push_back(newPoint);
+    // Add new point to trajectory; a repeated position needs no redraw
+    if (!m_trajectoryPoints.add(x, y)) {
+        return;
+    }
     // trace("point added...[%d,%d]", x, y);
 
+    // Draw only the segment to the new position, unless the renderer lost the trail drawn so far
+    if (m_incrementalTrail && !m_redrawPending.exchange(false)) {
+        std::lock_guard<std::mutex> lock(m_rendererMutex);
+        if (m_renderer) {
+            m_renderer->append(POINT{x, y});
+            m_surfaceBytes.store(m_renderer->surfaceBytes());
+        }
+        return;
+    }
+
     // Apply smoothing before rendering
     smoothTrajectory();
 
@@ -235,8 +318,10 @@ void OverlayUI::render(const std::vector<POINT>& points) {
         return;
     }
 
+    std::lock_guard<std::mutex> lock(m_rendererMutex);
     if (m_renderer) {
         m_renderer->render(points);
+        m_surfaceBytes.store(m_renderer->surfaceBytes());  // The surface grows with the trail
     }
 }
 
@@ -0,0 +1,92 @@
+#include "PointCloudRecognizer.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace VirtualDesktop {
+
+namespace {
+// Sum of the weights cloudDistance() gives the points of a cloud of n points: 1 + (n - 1) / n + ... + 1 / n
+constexpr double weightSum(int n) {
+    return (n + 1) / 2.0;
+}
+}  // namespace
+
+PointCloudRecognizer::Direction PointCloudRecognizer::recognize(const Positions& positions) const {
+    if (!prepareCandidate(positions)) {
+        return Direction::None;
+    }
+    const GesturePath& points = candidate();
+
+    // Clouds ignore the drawing order, so mirrored strokes such as left and right swipes have the same cloud.
+    // The score adds the distance between the start points, which also bounds it before the clouds are matched.
+    double bestScore = CLOUD_THRESHOLD;
+    const GestureTemplate* bestTemplate = nullptr;
+
+    forEachTemplate([&](const GestureTemplate& candidateTemplate) {
+        double startScore = START_WEIGHT * distance(points[0], candidateTemplate.points[0]);
+        if (startScore >= bestScore) {
+            return;
+        }
+        double score = startScore + greedyCloudMatch(points, candidateTemplate.points, bestScore - startScore);
+        if (score < bestScore) {
+            bestScore = score;
+            bestTemplate = &candidateTemplate;
+        }
+    });
+
+    return bestTemplate ? bestTemplate->direction : Direction::None;
+}
+
+double PointCloudRecognizer::greedyCloudMatch(
+        const GesturePath& points,
+        const GesturePath& templatePoints,
+        double limit) const {
+    // Matching starts from about sqrt(n) evenly spaced points, in both directions
+    const int step = static_cast<int>(std::floor(std::sqrt(static_cast<double>(CLOUD_POINTS))));
+    double sumLimit = limit * weightSum(CLOUD_POINTS);
+    for (int start = 0; start < CLOUD_POINTS; start += step) {
+        sumLimit = std::min(sumLimit, cloudDistance(points, templatePoints, start, sumLimit));
+        sumLimit = std::min(sumLimit, cloudDistance(templatePoints, points, start, sumLimit));
+    }
+    return sumLimit / weightSum(CLOUD_POINTS);
+}
+
+double PointCloudRecognizer::cloudDistance(
+        const GesturePath& cloud1,
+        const GesturePath& cloud2,
+        int start,
+        double limit) const {
+    bool matched[CLOUD_POINTS] = {};
+    double sum = 0.0;
+    for (int k = 0; k < CLOUD_POINTS; k++) {
+        const int i = (start + k) % CLOUD_POINTS;
+        const double x = cloud1.x[i * CLOUD_STRIDE];
+        const double y = cloud1.y[i * CLOUD_STRIDE];
+
+        int nearest = -1;
+        double nearestDistance = std::numeric_limits<double>::infinity();
+        for (int j = 0; j < CLOUD_POINTS; j++) {
+            if (matched[j]) {
+                continue;
+            }
+            double dx = cloud2.x[j * CLOUD_STRIDE] - x;
+            double dy = cloud2.y[j * CLOUD_STRIDE] - y;
+            double d = dx * dx + dy * dy;
+            if (d < nearestDistance) {
+                nearestDistance = d;
+                nearest = j;
+            }
+        }
+        matched[nearest] = true;
+
+        double weight = 1.0 - static_cast<double>(k) / CLOUD_POINTS;
+        sum += weight * std::sqrt(nearestDistance);
+        if (sum >= limit) {
+            return limit;  // Already no better than the best match so far
+        }
+    }
+    return sum;
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,32 @@
+#pragma once
+#include "UnistrokeRecognizer.h"
+
+namespace VirtualDesktop {
+
+/**
+ * @brief $P point-cloud recognizer
+ *
+ * Matches the stroke as an unordered cloud of points, so the result does not depend on how the stroke was
+ * drawn between its ends. Reuses the $1 resampling, normalization and templates, matching every other point.
+ */
+class PointCloudRecognizer : public UnistrokeRecognizer {
+public:
+    Direction recognize(const Positions& positions) const override;
+
+private:
+    static constexpr int CLOUD_POINTS = 32;                         // Points of each cloud
+    static constexpr int CLOUD_STRIDE = NUM_POINTS / CLOUD_POINTS;  // Resampled points per cloud point
+    static constexpr double CLOUD_THRESHOLD = 60.0;                 // Max score accepted
+    static constexpr double START_WEIGHT = 0.0625;                  // Weight of the start point distance in the score
+
+    static_assert(NUM_POINTS % CLOUD_POINTS == 0, "Clouds must sample the resampled points evenly");
+
+    // Smallest cloud distance over the greedy starting points, abandoned once it reaches limit
+    double greedyCloudMatch(const GesturePath& points, const GesturePath& templatePoints, double limit) const;
+
+    // Weighted sum of distances matching each point of cloud1 from start to its nearest unmatched point of
+    // cloud2; points matched earlier weigh more. Returns a value of at least limit once the sum reaches it.
+    double cloudDistance(const GesturePath& cloud1, const GesturePath& cloud2, int start, double limit) const;
+};
+
+}  // namespace VirtualDesktop
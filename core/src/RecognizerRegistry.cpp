@@ -0,0 +1,66 @@
+#include "IGestureRecognizer.h"
+#include "ChainCodeRecognizer.h"
+#include "PointCloudRecognizer.h"
+#include "SimpleRecognizer.h"
+#include "UnistrokeRecognizer.h"
+#include <map>
+#include <mutex>
+
+namespace VirtualDesktop {
+
+namespace {
+// Guards registry(): engines may be registered on one thread while the hook worker creates them on another
+std::mutex& registryMutex() {
+    static std::mutex mutex;
+    return mutex;
+}
+
+std::map<std::string, RecognizerFactory>& registry() {
+    static std::map<std::string, RecognizerFactory> factories = {
+            {"simple", [] { return std::make_unique<SimpleRecognizer>(); }},
+            {"unistroke",
+             [] { return std::make_unique<UnistrokeRecognizer>(UnistrokeRecognizer::Matcher::GoldenSection); }},
+            {"unistroke_streaming",
+             [] {
+                 auto recognizer = std::make_unique<UnistrokeRecognizer>(UnistrokeRecognizer::Matcher::GoldenSection);
+                 recognizer->setStreaming(true);
+                 return recognizer;
+             }},
+            {"protractor",
+             [] { return std::make_unique<UnistrokeRecognizer>(UnistrokeRecognizer::Matcher::Protractor); }},
+            {"point_cloud", [] { return std::make_unique<PointCloudRecognizer>(); }},
+            {"chain_code", [] { return std::make_unique<ChainCodeRecognizer>(); }},
+    };
+    return factories;
+}
+}  // namespace
+
+void registerRecognizer(const std::string& name, RecognizerFactory factory) {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    registry()[name] = std::move(factory);
+}
+
+std::unique_ptr<IGestureRecognizer> createRecognizer(const std::string& name) {
+    // The factory runs unlocked, so it may itself create or register engines
+    RecognizerFactory factory;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto it = registry().find(name);
+        if (it == registry().end()) {
+            return nullptr;
+        }
+        factory = it->second;
+    }
+    return factory();
+}
+
+std::vector<std::string> recognizerNames() {
+    std::lock_guard<std::mutex> lock(registryMutex());
+    std::vector<std::string> names;
+    for (const auto& entry : registry()) {
+        names.push_back(entry.first);
+    }
+    return names;
+}
+
+}  // namespace VirtualDesktop
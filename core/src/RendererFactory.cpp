@@ -1,15 +1,20 @@
 #include "IRenderer.h"
 #include "GdiRenderer.h"
+#include "MemoryRenderer.h"
+#include "utils.h"
 #include <memory>
 
 namespace VirtualDesktop {
 std::unique_ptr<IRenderer> createRendererByMode(RenderMode mode) {
     switch (mode) {
         case RenderMode::Direct2D:
-            // todo: direct2d render
-            return nullptr;
+            // There is no Direct2D renderer; configs asking for one still get a trail
+            trace("Direct2D renderer is not available, using GDI");
+            return std::make_unique<GdiRenderer>();
         case RenderMode::Gdiplus:
             return std::make_unique<GdiRenderer>();
+        case RenderMode::Memory:
+            return std::make_unique<MemoryRenderer>();
         default:
             return std::make_unique<GdiRenderer>();
     }
@@ -2,7 +2,9 @@
 #include <Windows.h>
 #include <fstream>
 #include <string>
+#include <utility>
 #include <algorithm>
+#include <cctype>
 #include "utils.h"
 
 namespace VirtualDesktop {
@@ -18,11 +20,19 @@ constexpr const char* DEFAULT_CONFIG = R"(
     "trigger_button": "X1",
     "sensitivity": 5,
     "line_width": 5,
-    "color": "#6495EDAA"
+    "color": "#6495EDAA",
+    "recognizer": "simple",
+    "early_commit": false,
+    "early_commit_confidence": 0.9,
+    "early_commit_distance": 200,
+    "stroke_capacity": 1024,
+    "stroke_decimation_radius": 1
   },
   "rendering": {
     "mode": "GDI+",
-    "transparency": 80
+    "transparency": 80,
+    "surface_trim_delay": 30,
+    "incremental_trail": true
   },
   "behavior": {
     "desktop_cycle": true,
@@ -32,6 +42,37 @@ constexpr const char* DEFAULT_CONFIG = R"(
 }
 )";
 
+constexpr uint32_t DEFAULT_OVERLAY_COLOR = 0xAA6495ED;  // "#6495EDAA" as 0xAARRGGBB
+
+// Parses "#RRGGBBAA" into 0xAARRGGBB
+uint32_t parseOverlayColor(const std::string& color) {
+    if (color.size() != 9 || color[0] != '#' ||
+        !std::all_of(color.begin() + 1, color.end(), [](char c) {
+            return std::isxdigit(static_cast<unsigned char>(c)) != 0;
+        })) {
+        return DEFAULT_OVERLAY_COLOR;
+    }
+    uint32_t rgba = static_cast<uint32_t>(std::stoul(color.substr(1), nullptr, 16));
+    return (rgba >> 8) | (rgba << 24);
+}
+
+// Reads a number clamped to [low, high]; reading it as a double first keeps huge or fractional values in the
+// file from overflowing the conversion
+int32_t clampedInt(const nlohmann::json& section, const char* key, int32_t fallback, int32_t low, int32_t high) {
+    double value = section.value(key, static_cast<double>(fallback));
+    return static_cast<int32_t>(std::clamp(value, static_cast<double>(low), static_cast<double>(high)));
+}
+
+RenderMode parseRenderMode(const std::string& mode) {
+    if (mode == "Direct2D") {
+        return RenderMode::Direct2D;
+    }
+    if (mode == "Memory") {
+        return RenderMode::Memory;
+    }
+    return RenderMode::Gdiplus;
+}
+
 }  // namespace
 
 // mousebutton to string
@@ -69,144 +110,357 @@ MouseButton stringToMouseButton(const std::string& button) {
     return MouseButton::None;
 }
 
+Settings::Settings() {
+    m_config = nlohmann::json::parse(DEFAULT_CONFIG);
+    publish(compile(m_config));
+}
+
 bool Settings::load(const std::wstring& filePath) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    bool loaded = true;
     try {
         std::string path = utf8_encode(filePath);
         std::ifstream file(path, std::ios::in | std::ios::binary);
         if (!file.is_open()) {
             m_config = nlohmann::json::parse(DEFAULT_CONFIG);
-            return false;
+            loaded = false;
         } else {
             try {
                 m_config = nlohmann::json::parse(file);
             } catch (const std::exception&) {
                 // if parsing fails, fall back to default config
                 m_config = nlohmann::json::parse(DEFAULT_CONFIG);
-                return false;
+                loaded = false;
             }
         }
+        publish(compile(m_config));
     } catch (const std::exception&) {
+        // Also reached when a value has the wrong type and cannot be compiled
         m_config = nlohmann::json::parse(DEFAULT_CONFIG);
+        loaded = false;
+        publish(compile(m_config));
+    }
+    m_dirty.store(false);
+    return loaded;
+}
+
+bool Settings::reload(const std::wstring& filePath) {
+    nlohmann::json config;
+    std::unique_ptr<const SettingsSnapshot> snapshot;
+    try {
+        std::ifstream file(utf8_encode(filePath), std::ios::in | std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        config = nlohmann::json::parse(file);
+        if (!config.is_object()) {
+            return false;
+        }
+        snapshot = compile(config);
+    } catch (const std::exception&) {
+        // A file caught halfway through an edit, or a mistyped value; keep the current settings
         return false;
     }
+
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config = std::move(config);
+    publish(std::move(snapshot));
+    m_dirty.store(false);
     return true;
 }
 
 bool Settings::save(const std::wstring& filePath) const {
+    // Write a temporary file and rename it over the config, so a crash or a concurrent reader never sees a
+    // truncated file
+    std::wstring tempPath = filePath + L".tmp";
     try {
-        std::string path = utf8_encode(filePath);
-        std::ofstream file(path, std::ios::out | std::ios::binary);
+        std::string text;
+        {
+            std::lock_guard<std::mutex> lock(m_writeMutex);
+            text = m_config.dump(4);
+            m_dirty.store(false);
+        }
+        std::ofstream file(utf8_encode(tempPath), std::ios::out | std::ios::binary | std::ios::trunc);
         if (!file.is_open()) {
+            m_dirty.store(true);
+            return false;
+        }
+        file << text;
+        file.close();
+        if (file.fail() ||
+            !MoveFileExW(tempPath.c_str(), filePath.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            DeleteFileW(tempPath.c_str());
+            m_dirty.store(true);
             return false;
         }
-        file << m_config.dump(4);
         return true;
     } catch (const std::exception&) {
+        m_dirty.store(true);
         return false;
     }
 }
 
+std::unique_ptr<const SettingsSnapshot> Settings::compile(const nlohmann::json& config) {
+    const nlohmann::json basic = config.value("basic", nlohmann::json::object());
+    const nlohmann::json gesture = config.value("gesture", nlohmann::json::object());
+    const nlohmann::json rendering = config.value("rendering", nlohmann::json::object());
+    const nlohmann::json behavior = config.value("behavior", nlohmann::json::object());
+
+    auto snapshot = std::make_unique<SettingsSnapshot>();
+    snapshot->autoStart = basic.value("auto_start", false);
+    snapshot->trayIcon = basic.value("tray_icon", true);
+
+    snapshot->triggerButton = stringToMouseButton(gesture.value("trigger_button", "X1"));
+    snapshot->sensitivity = clampedInt(gesture, "sensitivity", 5, MIN_SENSITIVITY, MAX_SENSITIVITY);
+    snapshot->lineWidth = clampedInt(gesture, "line_width", 5, MIN_LINE_WIDTH, MAX_LINE_WIDTH);
+    snapshot->overlayColor = parseOverlayColor(gesture.value("color", "#6495EDAA"));
+    snapshot->earlyCommit = gesture.value("early_commit", false);
+    snapshot->earlyCommitConfidence = std::clamp(
+            gesture.value("early_commit_confidence", 0.9), MIN_EARLY_COMMIT_CONFIDENCE, MAX_EARLY_COMMIT_CONFIDENCE);
+    snapshot->earlyCommitDistance = clampedInt(
+            gesture, "early_commit_distance", 200, MIN_EARLY_COMMIT_DISTANCE, MAX_EARLY_COMMIT_DISTANCE);
+    snapshot->strokeCapacity = clampedInt(gesture, "stroke_capacity", 1024, MIN_STROKE_CAPACITY, MAX_STROKE_CAPACITY);
+    snapshot->strokeDecimationRadius = clampedInt(
+            gesture, "stroke_decimation_radius", 1, MIN_STROKE_DECIMATION_RADIUS, MAX_STROKE_DECIMATION_RADIUS);
+
+    snapshot->renderingMode = parseRenderMode(rendering.value("mode", "GDI+"));
+    snapshot->transparency = clampedInt(rendering, "transparency", 80, MIN_TRANSPARENCY, MAX_TRANSPARENCY);
+    snapshot->surfaceTrimDelay = clampedInt(
+            rendering, "surface_trim_delay", 30, MIN_SURFACE_TRIM_DELAY, MAX_SURFACE_TRIM_DELAY);
+    snapshot->incrementalTrail = rendering.value("incremental_trail", true);
+
+    snapshot->desktopCycle = behavior.value("desktop_cycle", true);
+    snapshot->desktopPreview = behavior.value("desktop_preview", true);
+    snapshot->switchAnimation = behavior.value("switch_animation", true);
+    return snapshot;
+}
+
+void Settings::publish(std::unique_ptr<const SettingsSnapshot> snapshot) {
+    m_snapshot.store(snapshot.get(), std::memory_order_release);
+    m_snapshots.push_back(std::move(snapshot));
+}
+
+void Settings::update() {
+    publish(compile(m_config));
+    m_dirty.store(true);
+    if (m_onChange) {
+        m_onChange();
+    }
+}
+
+void Settings::setChangeCallback(std::function<void()> onChange) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_onChange = std::move(onChange);
+}
+
 // Basic settings
 bool Settings::isAutoStartEnabled() const {
-    return m_config.value("basic", nlohmann::json::object()).value("auto_start", false);
+    return snapshot().autoStart;
 }
 
 void Settings::setAutoStartEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     m_config["basic"]["auto_start"] = enabled;
+    update();
 }
 
 bool Settings::isTrayIconEnabled() const {
-    return m_config.value("basic", nlohmann::json::object()).value("tray_icon", true);
+    return snapshot().trayIcon;
 }
 
 void Settings::setTrayIconEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     m_config["basic"]["tray_icon"] = enabled;
+    update();
 }
 
 // Gesture settings
 MouseButton Settings::getTriggerButton() const {
-    std::string button = m_config.value("gesture", nlohmann::json::object()).value("trigger_button", "X1");
-    return stringToMouseButton(button);
+    return snapshot().triggerButton;
 }
 
 void Settings::setTriggerButton(MouseButton button) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     m_config["gesture"]["trigger_button"] = mouseButtonToString(button);
+    update();
 }
 
 int Settings::getGestureSensitivity() const {
-    return m_config.value("gesture", nlohmann::json::object()).value("sensitivity", 5);
+    return snapshot().sensitivity;
 }
 
 void Settings::setGestureSensitivity(int value) {
-    m_config["gesture"]["sensitivity"] = std::clamp(value, 1, 10);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["sensitivity"] = std::clamp(value, MIN_SENSITIVITY, MAX_SENSITIVITY);
+    update();
 }
 
 std::string Settings::getOverlayColor() const {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     std::string color = m_config.value("gesture", nlohmann::json::object()).value("color", "#6495EDAA");
     return color;
 }
 
 void Settings::setOverlayColor(const std::string& color) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     if (color.size() == 9 && color[0] == '#') {
         m_config["gesture"]["color"] = color;
     }
+    update();
 }
 
 int Settings::getGestureLineWidth() const {
-    return m_config.value("gesture", nlohmann::json::object()).value("line_width", 5);
+    return snapshot().lineWidth;
 }
 
 void Settings::setGestureLineWidth(int width) {
-    m_config["gesture"]["line_width"] = std::clamp(width, 1, 10);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["line_width"] = std::clamp(width, MIN_LINE_WIDTH, MAX_LINE_WIDTH);
+    update();
+}
+
+std::string Settings::getRecognizer() const {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    return m_config.value("gesture", nlohmann::json::object()).value("recognizer", "simple");
+}
+
+void Settings::setRecognizer(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    if (!name.empty()) {
+        m_config["gesture"]["recognizer"] = name;
+    }
+    update();
+}
+
+bool Settings::isEarlyCommitEnabled() const {
+    return snapshot().earlyCommit;
+}
+
+void Settings::setEarlyCommitEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["early_commit"] = enabled;
+    update();
+}
+
+double Settings::getEarlyCommitConfidence() const {
+    return snapshot().earlyCommitConfidence;
+}
+
+void Settings::setEarlyCommitConfidence(double value) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["early_commit_confidence"] =
+            std::clamp(value, MIN_EARLY_COMMIT_CONFIDENCE, MAX_EARLY_COMMIT_CONFIDENCE);
+    update();
+}
+
+int Settings::getEarlyCommitDistance() const {
+    return snapshot().earlyCommitDistance;
+}
+
+void Settings::setEarlyCommitDistance(int value) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["early_commit_distance"] =
+            std::clamp(value, MIN_EARLY_COMMIT_DISTANCE, MAX_EARLY_COMMIT_DISTANCE);
+    update();
+}
+
+int Settings::getStrokeCapacity() const {
+    return snapshot().strokeCapacity;
+}
+
+void Settings::setStrokeCapacity(int value) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["stroke_capacity"] = std::clamp(value, MIN_STROKE_CAPACITY, MAX_STROKE_CAPACITY);
+    update();
+}
+
+int Settings::getStrokeDecimationRadius() const {
+    return snapshot().strokeDecimationRadius;
+}
+
+void Settings::setStrokeDecimationRadius(int value) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["gesture"]["stroke_decimation_radius"] =
+            std::clamp(value, MIN_STROKE_DECIMATION_RADIUS, MAX_STROKE_DECIMATION_RADIUS);
+    update();
 }
 
 // Rendering settings
 RenderMode Settings::getRenderingMode() const {
-    std::string mode = m_config.value("rendering", nlohmann::json::object()).value("mode", "GDI+");
-    if (mode == "Direct2D")
-        return RenderMode::Direct2D;
-    return RenderMode::Gdiplus;
+    return snapshot().renderingMode;
 }
 
 void Settings::setRenderingMode(RenderMode mode) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     if (mode == RenderMode::Gdiplus) {
         m_config["rendering"]["mode"] = "GDI+";
     } else if (mode == RenderMode::Direct2D) {
         m_config["rendering"]["mode"] = "Direct2D";
+    } else if (mode == RenderMode::Memory) {
+        m_config["rendering"]["mode"] = "Memory";
     }
+    update();
 }
 
 int Settings::getTransparency() const {
-    return m_config.value("rendering", nlohmann::json::object()).value("transparency", 80);
+    return snapshot().transparency;
 }
 
 void Settings::setTransparency(int value) {
-    m_config["rendering"]["transparency"] = std::clamp(value, 0, 100);
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["rendering"]["transparency"] = std::clamp(value, MIN_TRANSPARENCY, MAX_TRANSPARENCY);
+    update();
+}
+
+int Settings::getSurfaceTrimDelay() const {
+    return snapshot().surfaceTrimDelay;
+}
+
+void Settings::setSurfaceTrimDelay(int seconds) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["rendering"]["surface_trim_delay"] = std::clamp(seconds, MIN_SURFACE_TRIM_DELAY, MAX_SURFACE_TRIM_DELAY);
+    update();
+}
+
+bool Settings::isIncrementalTrailEnabled() const {
+    return snapshot().incrementalTrail;
+}
+
+void Settings::setIncrementalTrailEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    m_config["rendering"]["incremental_trail"] = enabled;
+    update();
 }
 
 // Behavior settings
 bool Settings::isDesktopCycleEnabled() const {
-    return m_config.value("behavior", nlohmann::json::object()).value("desktop_cycle", true);
+    return snapshot().desktopCycle;
 }
 
 void Settings::setDesktopCycleEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     m_config["behavior"]["desktop_cycle"] = enabled;
+    update();
 }
 
 bool Settings::isDesktopPreviewEnabled() const {
-    return m_config.value("behavior", nlohmann::json::object()).value("desktop_preview", true);
+    return snapshot().desktopPreview;
 }
 
 void Settings::setDesktopPreviewEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     m_config["behavior"]["desktop_preview"] = enabled;
+    update();
 }
 
 bool Settings::isSwitchAnimationEnabled() const {
-    return m_config.value("behavior", nlohmann::json::object()).value("switch_animation", true);
+    return snapshot().switchAnimation;
 }
 
 void Settings::setSwitchAnimationEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(m_writeMutex);
     m_config["behavior"]["switch_animation"] = enabled;
+    update();
 }
 
 }  // namespace VirtualDesktop
\ No newline at end of file
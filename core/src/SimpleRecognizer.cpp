@@ -0,0 +1,45 @@
+#include "SimpleRecognizer.h"
+#include <cstdlib>
+
+namespace VirtualDesktop {
+
+void SimpleRecognizer::reset() {
+}
+
+void SimpleRecognizer::addPoint(int32_t /*x*/, int32_t /*y*/) {
+}
+
+SimpleRecognizer::Direction SimpleRecognizer::recognize(const Positions& positions) const {
+    if (positions.size() < 3) {  // Need at least 3 points for recognition
+        return Direction::None;
+    }
+
+    // Total displacement from first to last recorded position
+    int32_t totalDx = positions.back().first - positions.front().first;
+    int32_t totalDy = positions.back().second - positions.front().second;
+
+    // Check if movement is significant enough
+    const int32_t MIN_SWIPE_DISTANCE = 50;
+    if (std::abs(totalDx) < MIN_SWIPE_DISTANCE && std::abs(totalDy) < MIN_SWIPE_DISTANCE) {
+        return Direction::None;
+    }
+
+    // Determine primary direction based on dominant axis
+    if (std::abs(totalDx) >= std::abs(totalDy)) {
+        // Horizontal movement dominates
+        if (totalDx > 0) {
+            return Direction::Right;
+        } else {
+            return Direction::Left;
+        }
+    } else {
+        // Vertical movement dominates
+        if (totalDy > 0) {
+            return Direction::Down;
+        } else {
+            return Direction::Up;
+        }
+    }
+}
+
+}  // namespace VirtualDesktop
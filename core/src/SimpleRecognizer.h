@@ -0,0 +1,16 @@
+#pragma once
+#include "IGestureRecognizer.h"
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Classifies a stroke by the dominant axis of its displacement from the first to the last position
+ */
+class SimpleRecognizer : public IGestureRecognizer {
+public:
+    void reset() override;
+    void addPoint(int32_t x, int32_t y) override;
+    Direction recognize(const Positions& positions) const override;
+};
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,96 @@
+#include "StrokeRasterizer.h"
+#include <algorithm>
+#include <cmath>
+
+namespace VirtualDesktop {
+
+namespace {
+
+// Rounds channel * alpha / 255 to nearest without dividing; exact for all byte inputs
+inline uint32_t premultiply(uint32_t channel, uint32_t alpha) {
+    uint32_t x = channel * alpha + 127;
+    return (x + 1 + (x >> 8)) >> 8;
+}
+
+}  // namespace
+
+StrokeRasterizer::StrokeRasterizer() {
+    setStyle(0x6495ED, 0xAA, 5.0f);  // Cornflower Blue
+}
+
+void StrokeRasterizer::setStyle(uint32_t color, uint8_t alpha, float width) {
+    m_radius = std::max(width, 1.0f) / 2.0f;
+
+    const uint32_t r = (color >> 16) & 0xFF;
+    const uint32_t g = (color >> 8) & 0xFF;
+    const uint32_t b = color & 0xFF;
+    for (uint32_t coverage = 0; coverage < 256; ++coverage) {
+        uint32_t a = premultiply(alpha, coverage);
+        m_pixelByCoverage[coverage] =
+                (a << 24) | (premultiply(r, a) << 16) | (premultiply(g, a) << 8) | premultiply(b, a);
+    }
+}
+
+int StrokeRasterizer::reach() const {
+    return static_cast<int>(std::ceil(m_radius + 0.5f));
+}
+
+void StrokeRasterizer::drawSegment(
+        uint32_t* pixels,
+        size_t stride,
+        int left,
+        int top,
+        int width,
+        int height,
+        float ax,
+        float ay,
+        float bx,
+        float by) const {
+    // Coverage is 1 up to inner and falls to 0 at outer, both measured from the segment
+    const float outer = m_radius + 0.5f;
+    const float inner = m_radius - 0.5f;
+    const float outer2 = outer * outer;
+    const float inner2 = inner * inner;
+
+    // Pixels in the capsule's bounding box, clipped to the rectangle
+    const int x0 = std::max(left, static_cast<int>(std::floor(std::min(ax, bx) - outer)));
+    const int y0 = std::max(top, static_cast<int>(std::floor(std::min(ay, by) - outer)));
+    const int x1 = std::min(left + width - 1, static_cast<int>(std::ceil(std::max(ax, bx) + outer)));
+    const int y1 = std::min(top + height - 1, static_cast<int>(std::ceil(std::max(ay, by) + outer)));
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    const float dx = bx - ax;
+    const float dy = by - ay;
+    const float length2 = dx * dx + dy * dy;
+    const float inverseLength2 = length2 > 0.0f ? 1.0f / length2 : 0.0f;
+    for (int y = y0; y <= y1; ++y) {
+        uint32_t* row = pixels + static_cast<size_t>(y - top) * stride;
+        const float py = static_cast<float>(y) - ay;
+        for (int x = x0; x <= x1; ++x) {
+            // Distance from the pixel centre to the closest point of the segment
+            const float px = static_cast<float>(x) - ax;
+            const float t = std::clamp((px * dx + py * dy) * inverseLength2, 0.0f, 1.0f);
+            const float ex = px - t * dx;
+            const float ey = py - t * dy;
+            const float distance2 = ex * ex + ey * ey;
+            if (distance2 >= outer2) {
+                continue;
+            }
+
+            uint32_t coverage = 255;
+            if (distance2 > inner2) {
+                float edge = std::clamp(outer - std::sqrt(distance2), 0.0f, 1.0f);
+                coverage = static_cast<uint32_t>(edge * 255.0f + 0.5f);
+            }
+            const uint32_t pixel = m_pixelByCoverage[coverage];
+            uint32_t& target = row[x - left];
+            if ((pixel >> 24) > (target >> 24)) {
+                target = pixel;
+            }
+        }
+    }
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Rasterizes anti-aliased, round-capped stroke segments straight into premultiplied BGRA
+ *
+ * Each segment is drawn as a capsule, the set of points within half the stroke width of the segment. A pixel's
+ * coverage falls off linearly across the one-pixel band around the capsule's edge, by the distance from the
+ * pixel centre to the segment. Overlapping segments keep the higher coverage instead of blending twice, so
+ * joins are round and the whole stroke has one even opacity. Pixel (x, y) is centred on integer coordinates.
+ */
+class StrokeRasterizer {
+public:
+    StrokeRasterizer();
+
+    /**
+     * @brief Sets the stroke style
+     * @param color Stroke color as 0x00RRGGBB
+     * @param alpha Opacity of fully covered pixels (0-255)
+     * @param width Stroke width in pixels, at least 1
+     */
+    void setStyle(uint32_t color, uint8_t alpha, float width);
+
+    // Whole pixels a stroke reaches beyond its segment
+    int reach() const;
+
+    /**
+     * @brief Draws segment a-b into a rectangle of the target surface
+     * @param pixels Top-left pixel of the rectangle, premultiplied BGRA
+     * @param stride Pixels from one row of the rectangle to the next
+     * @param left, top Surface position of the rectangle's top-left pixel
+     * @param width, height Size of the rectangle; the stroke is clipped to it
+     */
+    void drawSegment(
+            uint32_t* pixels,
+            size_t stride,
+            int left,
+            int top,
+            int width,
+            int height,
+            float ax,
+            float ay,
+            float bx,
+            float by) const;
+
+private:
+    float m_radius;
+    uint32_t m_pixelByCoverage[256];  // Premultiplied BGRA of the stroke color at each coverage
+};
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,84 @@
+#include "TiledSurface.h"
+#include <algorithm>
+#include <cstring>
+
+namespace VirtualDesktop {
+
+void TiledSurface::resize(int width, int height) {
+    clear();
+    m_columns = (std::max(width, 0) + TILE_SIZE - 1) / TILE_SIZE;
+    m_rows = (std::max(height, 0) + TILE_SIZE - 1) / TILE_SIZE;
+    m_grid.assign(static_cast<size_t>(m_columns) * static_cast<size_t>(m_rows), -1);
+}
+
+int32_t* TiledSurface::cell(int tx, int ty) {
+    if (tx < 0 || ty < 0 || tx >= m_columns || ty >= m_rows) {
+        return nullptr;
+    }
+    return &m_grid[static_cast<size_t>(ty) * static_cast<size_t>(m_columns) + static_cast<size_t>(tx)];
+}
+
+TiledSurface::Tile* TiledSurface::acquire(int tx, int ty) {
+    int32_t* index = cell(tx, ty);
+    if (!index) {
+        return nullptr;
+    }
+    if (*index >= 0) {
+        return &m_tiles[*index];
+    }
+
+    if (m_free.empty()) {
+        m_blocks.push_back(std::make_unique<uint32_t[]>(BLOCK_TILES * TILE_PIXELS));
+        uint32_t* block = m_blocks.back().get();
+        for (size_t i = 0; i < BLOCK_TILES; ++i) {
+            m_free.push_back(block + i * TILE_PIXELS);
+        }
+    }
+    uint32_t* pixels = m_free.back();
+    m_free.pop_back();
+    memset(pixels, 0, TILE_BYTES);
+
+    *index = static_cast<int32_t>(m_tiles.size());
+    m_tiles.push_back({tx, ty, pixels});
+    return &m_tiles.back();
+}
+
+TiledSurface::Tile* TiledSurface::find(int tx, int ty) {
+    int32_t* index = cell(tx, ty);
+    return index && *index >= 0 ? &m_tiles[*index] : nullptr;
+}
+
+void TiledSurface::erase(int tx, int ty) {
+    int32_t* index = cell(tx, ty);
+    if (!index || *index < 0) {
+        return;
+    }
+
+    // Move the last tile into the gap so the list stays dense
+    size_t slot = static_cast<size_t>(*index);
+    m_free.push_back(m_tiles[slot].pixels);
+    *index = -1;
+    if (slot + 1 != m_tiles.size()) {
+        m_tiles[slot] = m_tiles.back();
+        *cell(m_tiles[slot].tx, m_tiles[slot].ty) = static_cast<int32_t>(slot);
+    }
+    m_tiles.pop_back();
+}
+
+void TiledSurface::clear() {
+    for (const Tile& tile : m_tiles) {
+        m_free.push_back(tile.pixels);
+        *cell(tile.tx, tile.ty) = -1;
+    }
+    m_tiles.clear();
+}
+
+void TiledSurface::release() {
+    clear();
+    m_free.clear();
+    m_free.shrink_to_fit();
+    m_blocks.clear();
+    m_blocks.shrink_to_fit();
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,98 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Sparse 32-bit pixel surface made of square tiles that only exist where something was drawn
+ *
+ * Tiles are taken from a pool of fixed-size blocks. The pool grows on demand and only returns its memory in
+ * release(), so a warm pool draws gestures without allocating. Memory follows the drawn area rather than the
+ * surface size; the grid that locates tiles costs 4 bytes per tile position.
+ */
+class TiledSurface {
+public:
+    static constexpr int TILE_SIZE = 64;  // Tile edge in pixels
+    static constexpr int TILE_PIXELS = TILE_SIZE * TILE_SIZE;
+    static constexpr size_t TILE_BYTES = TILE_PIXELS * sizeof(uint32_t);
+
+    struct Tile {
+        int32_t tx;        // Column in the tile grid
+        int32_t ty;        // Row in the tile grid
+        uint32_t* pixels;  // TILE_SIZE rows of TILE_SIZE pixels
+    };
+
+    TiledSurface() = default;
+    TiledSurface(const TiledSurface&) = delete;
+    TiledSurface& operator=(const TiledSurface&) = delete;
+
+    /**
+     * @brief Sets the surface size in pixels and returns all tiles to the pool
+     */
+    void resize(int width, int height);
+
+    int columns() const {
+        return m_columns;
+    }
+
+    int rows() const {
+        return m_rows;
+    }
+
+    /**
+     * @brief Returns the tile at a grid position, taking a cleared one from the pool if it does not exist
+     * @return nullptr outside the grid; otherwise valid until the next acquire(), erase() or clear()
+     */
+    Tile* acquire(int tx, int ty);
+
+    /**
+     * @brief Returns the tile at a grid position, or nullptr if it does not exist
+     */
+    Tile* find(int tx, int ty);
+
+    /**
+     * @brief Returns the tile at a grid position to the pool
+     */
+    void erase(int tx, int ty);
+
+    /**
+     * @brief Returns all tiles to the pool, keeping the pool's memory
+     */
+    void clear();
+
+    /**
+     * @brief Returns all tiles and frees the pool
+     */
+    void release();
+
+    // Existing tiles in no particular order
+    const std::vector<Tile>& tiles() const {
+        return m_tiles;
+    }
+
+    bool empty() const {
+        return m_tiles.empty();
+    }
+
+    // Bytes held by the pool, whether its tiles are in use or not
+    size_t poolBytes() const {
+        return m_blocks.size() * BLOCK_TILES * TILE_BYTES;
+    }
+
+private:
+    static constexpr size_t BLOCK_TILES = 8;  // Tiles per pool allocation, 128 KB
+
+    int32_t* cell(int tx, int ty);
+
+    int m_columns = 0;
+    int m_rows = 0;
+    std::vector<int32_t> m_grid;                        // Index into m_tiles per grid position, -1 if none
+    std::vector<Tile> m_tiles;                          // Existing tiles
+    std::vector<std::unique_ptr<uint32_t[]>> m_blocks;  // Pool memory
+    std::vector<uint32_t*> m_free;                      // Pool tiles not in use
+};
+
+}  // namespace VirtualDesktop
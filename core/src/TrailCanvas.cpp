@@ -0,0 +1,240 @@
+#include "TrailCanvas.h"
+#include <algorithm>
+#include <cstring>
+
+namespace VirtualDesktop {
+
+namespace {
+
+// Tile row or column holding a surface coordinate, rounding down for coordinates left of or above the surface
+int tileOf(int32_t pixel) {
+    const int32_t size = TiledSurface::TILE_SIZE;
+    return pixel >= 0 ? pixel / size : -((size - 1 - pixel) / size);
+}
+
+// Whether segment a-b passes through [left, right] x [top, bottom], by Liang-Barsky clipping
+bool segmentTouchesRect(
+        TrailCanvas::Point a,
+        TrailCanvas::Point b,
+        double left,
+        double top,
+        double right,
+        double bottom) {
+    double t0 = 0.0, t1 = 1.0;
+    const double dx = static_cast<double>(b.x - a.x);
+    const double dy = static_cast<double>(b.y - a.y);
+    const double p[4] = {-dx, dx, -dy, dy};
+    const double q[4] = {a.x - left, right - a.x, a.y - top, bottom - a.y};
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0.0) {
+            if (q[i] < 0.0) {
+                return false;
+            }
+        } else {
+            double t = q[i] / p[i];
+            if (p[i] < 0.0) {
+                t0 = std::max(t0, t);
+            } else {
+                t1 = std::min(t1, t);
+            }
+            if (t0 > t1) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+TrailCanvas::Rect uniteRects(const TrailCanvas::Rect& a, const TrailCanvas::Rect& b) {
+    if (a.empty()) {
+        return b;
+    }
+    if (b.empty()) {
+        return a;
+    }
+    return {std::min(a.left, b.left), std::min(a.top, b.top), std::max(a.right, b.right), std::max(a.bottom, b.bottom)};
+}
+
+}  // namespace
+
+TrailCanvas::TrailCanvas() :
+        m_width(0),
+        m_height(0),
+        m_lastPoint{},
+        m_hasLastPoint(false),
+        m_drawnArea{},
+        m_area{} {
+}
+
+void TrailCanvas::resize(int width, int height) {
+    m_width = std::max(width, 0);
+    m_height = std::max(height, 0);
+    m_tiles.resize(m_width, m_height);
+    clear();
+}
+
+void TrailCanvas::setStyle(uint32_t color, uint8_t alpha, float width) {
+    m_rasterizer.setStyle(color, alpha, width);
+}
+
+void TrailCanvas::setThreads(unsigned threads) {
+    m_workers.setThreads(threads);
+}
+
+void TrailCanvas::clear() {
+    m_tiles.clear();
+    m_hasLastPoint = false;
+    m_drawnArea = {};
+    m_area = {};
+    m_drawnTiles.clear();
+    m_erasedTiles.clear();
+}
+
+void TrailCanvas::release() {
+    clear();
+    m_tiles.release();
+    m_workers.stop();
+}
+
+void TrailCanvas::collectTileSegments() {
+    // Each segment is padded by the distance the stroke reaches beyond it
+    const int size = TiledSurface::TILE_SIZE;
+    const int pad = m_rasterizer.reach();
+    m_tileSegments.clear();
+    for (size_t i = 0; i + 1 < m_points.size(); ++i) {
+        const Point a = m_points[i];
+        const Point b = m_points[i + 1];
+        int tx0 = std::max(0, tileOf(std::min(a.x, b.x) - pad));
+        int ty0 = std::max(0, tileOf(std::min(a.y, b.y) - pad));
+        int tx1 = std::min(m_tiles.columns() - 1, tileOf(std::max(a.x, b.x) + pad));
+        int ty1 = std::min(m_tiles.rows() - 1, tileOf(std::max(a.y, b.y) + pad));
+        for (int ty = ty0; ty <= ty1; ++ty) {
+            for (int tx = tx0; tx <= tx1; ++tx) {
+                // Pixel centres of the tile, padded
+                int left = tx * size - pad;
+                int top = ty * size - pad;
+                int right = (tx + 1) * size - 1 + pad;
+                int bottom = (ty + 1) * size - 1 + pad;
+                if (segmentTouchesRect(a, b, left, top, right, bottom)) {
+                    uint64_t tile = static_cast<uint64_t>(ty) * m_tiles.columns() + tx;
+                    m_tileSegments.push_back((tile << 32) | i);
+                }
+            }
+        }
+    }
+    std::sort(m_tileSegments.begin(), m_tileSegments.end());
+}
+
+void TrailCanvas::drawTile(const TiledSurface::Tile& tile, size_t begin, size_t end, bool replace) {
+    const int left = tile.tx * TiledSurface::TILE_SIZE;
+    const int top = tile.ty * TiledSurface::TILE_SIZE;
+    if (replace) {
+        memset(tile.pixels, 0, TiledSurface::TILE_BYTES);
+    }
+
+    // Segments keep the more opaque pixel, so those already in the tile stay as they were drawn
+    for (size_t i = begin; i < end; ++i) {
+        const Point a = m_points[static_cast<uint32_t>(m_tileSegments[i])];
+        const Point b = m_points[static_cast<uint32_t>(m_tileSegments[i]) + 1];
+        m_rasterizer.drawSegment(
+                tile.pixels,
+                TiledSurface::TILE_SIZE,
+                left,
+                top,
+                TiledSurface::TILE_SIZE,
+                TiledSurface::TILE_SIZE,
+                static_cast<float>(a.x),
+                static_cast<float>(a.y),
+                static_cast<float>(b.x),
+                static_cast<float>(b.y));
+    }
+}
+
+void TrailCanvas::drawTiles(bool replace) {
+    const int size = TiledSurface::TILE_SIZE;
+    Rect area = {m_width, m_height, 0, 0};
+    m_drawnTiles.clear();
+    m_drawnSegments.clear();
+    for (size_t begin = 0; begin < m_tileSegments.size();) {
+        uint64_t tile = m_tileSegments[begin] >> 32;
+        size_t end = begin + 1;
+        while (end < m_tileSegments.size() && (m_tileSegments[end] >> 32) == tile) {
+            ++end;
+        }
+        int tx = static_cast<int>(tile % m_tiles.columns());
+        int ty = static_cast<int>(tile / m_tiles.columns());
+        m_drawnTiles.push_back(*m_tiles.acquire(tx, ty));
+        m_drawnSegments.push_back(begin);
+        area.left = std::min(area.left, tx * size);
+        area.top = std::min(area.top, ty * size);
+        area.right = std::max(area.right, (tx + 1) * size);
+        area.bottom = std::max(area.bottom, (ty + 1) * size);
+        begin = end;
+    }
+    m_drawnSegments.push_back(m_tileSegments.size());
+
+    // Taking tiles from the pool is serial, drawing them is not: each job only writes its own tile's pixels
+    auto draw = [this, replace](size_t i) {
+        drawTile(m_drawnTiles[i], m_drawnSegments[i], m_drawnSegments[i + 1], replace);
+    };
+    if (m_drawnTiles.size() >= PARALLEL_MIN_TILES) {
+        m_workers.run(m_drawnTiles.size(), draw);
+    } else {
+        for (size_t i = 0; i < m_drawnTiles.size(); ++i) {
+            draw(i);
+        }
+    }
+
+    area.right = std::min(area.right, m_width);
+    area.bottom = std::min(area.bottom, m_height);
+    m_drawnArea = m_drawnTiles.empty() ? Rect{} : area;
+}
+
+void TrailCanvas::render(const Point* points, size_t count) {
+    m_drawnTiles.clear();
+    m_erasedTiles.clear();
+    if (count == 0) {
+        return;
+    }
+
+    m_points.assign(points, points + count);
+    m_lastPoint = m_points.back();
+    m_hasLastPoint = true;
+    collectTileSegments();
+
+    // Drop tiles the trail no longer passes through, e.g. after the stroke buffer discarded old points
+    const std::vector<TiledSurface::Tile>& tiles = m_tiles.tiles();
+    for (size_t i = tiles.size(); i-- > 0;) {
+        uint64_t tile = static_cast<uint64_t>(tiles[i].ty) * m_tiles.columns() + tiles[i].tx;
+        auto it = std::lower_bound(m_tileSegments.begin(), m_tileSegments.end(), tile << 32);
+        if (it == m_tileSegments.end() || (*it >> 32) != tile) {
+            m_erasedTiles.push_back({tiles[i].tx, tiles[i].ty, nullptr});
+            m_tiles.erase(tiles[i].tx, tiles[i].ty);
+        }
+    }
+
+    // Redraw every tile the trail passes through
+    drawTiles(true);
+    m_area = m_drawnArea;
+}
+
+void TrailCanvas::append(Point point) {
+    m_drawnTiles.clear();
+    m_erasedTiles.clear();
+    if (!m_hasLastPoint) {
+        m_lastPoint = point;
+        m_hasLastPoint = true;
+        return;
+    }
+
+    // Add the new segment to the tiles it passes through
+    m_points.clear();
+    m_points.push_back(m_lastPoint);
+    m_points.push_back(point);
+    m_lastPoint = point;
+    collectTileSegments();
+    drawTiles(false);
+    m_area = uniteRects(m_area, m_drawnArea);
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,149 @@
+#pragma once
+#include "StrokeRasterizer.h"
+#include "TiledSurface.h"
+#include "WorkerPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Platform-independent drawing of the gesture trail into a sparse tiled surface
+ *
+ * Holds the trail as premultiplied BGRA tiles drawn by StrokeRasterizer, ready to be presented as they are.
+ * render() redraws a whole trail, while append() only adds the newest segment to the tiles it passes through.
+ * After each call, drawnTiles() and erasedTiles() tell a presenter which tiles to copy out or clear.
+ *
+ * Tiles are independent, so a frame that draws many of them, such as a full redraw of a long swipe across a wide
+ * virtual screen, spreads them over a WorkerPool. Small frames, including every append(), stay on the calling
+ * thread where waking the workers would cost more than it saves.
+ */
+class TrailCanvas {
+public:
+    struct Point {
+        int32_t x;
+        int32_t y;
+    };
+
+    // Pixel area [left, right) x [top, bottom) of the surface
+    struct Rect {
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+
+        bool empty() const {
+            return left >= right || top >= bottom;
+        }
+    };
+
+    TrailCanvas();
+    TrailCanvas(const TrailCanvas&) = delete;
+    TrailCanvas& operator=(const TrailCanvas&) = delete;
+
+    /**
+     * @brief Sets the surface size in pixels and drops the trail
+     */
+    void resize(int width, int height);
+
+    /**
+     * @brief Sets the trail style, which applies from the next render() or append()
+     * @param color Trail color as 0x00RRGGBB
+     * @param alpha Opacity of the trail (0-255)
+     * @param width Line width in pixels
+     */
+    void setStyle(uint32_t color, uint8_t alpha, float width);
+
+    /**
+     * @brief Sets the threads that draw tiles, the calling thread included
+     * @param threads 1 draws on the calling thread only; 0 picks the hardware concurrency
+     */
+    void setThreads(unsigned threads);
+
+    /**
+     * @brief Redraws the trail through points, in surface coordinates
+     *
+     * Tiles the trail no longer passes through are erased. A single point draws nothing, but append() continues
+     * the trail from it.
+     */
+    void render(const Point* points, size_t count);
+
+    /**
+     * @brief Draws the segment from the last point to a new one
+     *
+     * Without a last point, only remembers the new one.
+     */
+    void append(Point point);
+
+    /**
+     * @brief Drops the trail, keeping the tile pool for the next one
+     */
+    void clear();
+
+    /**
+     * @brief Drops the trail, frees the tile pool and ends the worker threads
+     */
+    void release();
+
+    const TiledSurface& surface() const {
+        return m_tiles;
+    }
+
+    // Tiles the last render() or append() drew
+    const std::vector<TiledSurface::Tile>& drawnTiles() const {
+        return m_drawnTiles;
+    }
+
+    // Tiles the last render() erased; only their grid positions are valid
+    const std::vector<TiledSurface::Tile>& erasedTiles() const {
+        return m_erasedTiles;
+    }
+
+    // Bounding box of drawnTiles(), clipped to the surface
+    const Rect& drawnArea() const {
+        return m_drawnArea;
+    }
+
+    // Bounding box of all tiles, clipped to the surface
+    const Rect& area() const {
+        return m_area;
+    }
+
+    // Bytes held by the tile pool
+    size_t bytes() const {
+        return m_tiles.poolBytes();
+    }
+
+private:
+    // Tiles a frame draws before it is worth going parallel, a few times the break-even renderer_bench --backends
+    // pool measures, so that workers waking late on a busy machine still pay off
+    static constexpr size_t PARALLEL_MIN_TILES = 8;
+
+    // Lists the tiles each segment of m_points passes through in m_tileSegments, sorted by tile
+    void collectTileSegments();
+    // Draws the tiles listed in m_tileSegments into m_drawnTiles, replacing or adding to their pixels
+    void drawTiles(bool replace);
+    // Draws the segments listed in m_tileSegments[begin, end) into one tile
+    void drawTile(const TiledSurface::Tile& tile, size_t begin, size_t end, bool replace);
+
+    TiledSurface m_tiles;
+    StrokeRasterizer m_rasterizer;
+    WorkerPool m_workers;
+    int m_width;
+    int m_height;
+
+    Point m_lastPoint;  // End of the drawn trail
+    bool m_hasLastPoint;
+    Rect m_drawnArea;
+    Rect m_area;
+
+    // Per-frame scratch, kept to avoid allocating while drawing
+    std::vector<Point> m_points;
+    std::vector<uint64_t> m_tileSegments;  // Tile index in the high half, segment index in the low half
+    std::vector<TiledSurface::Tile> m_drawnTiles;
+    std::vector<size_t> m_drawnSegments;  // Where each drawn tile's entries start in m_tileSegments, plus the end
+    std::vector<TiledSurface::Tile> m_erasedTiles;
+};
+
+}  // namespace VirtualDesktop
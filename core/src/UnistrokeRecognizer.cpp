@@ -0,0 +1,583 @@
+#define _USE_MATH_DEFINES
+#include "UnistrokeRecognizer.h"
+#include "GestureKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+namespace VirtualDesktop {
+
+namespace {
+// Square root by Newton's method, usable in constant expressions
+constexpr double constexprSqrt(double value) {
+    double root = value > 1.0 ? value : 1.0;
+    for (int i = 0; i < 64; i++) {
+        root = 0.5 * (root + value / root);
+    }
+    return root;
+}
+}  // namespace
+
+constexpr UnistrokeRecognizer::GestureTemplate UnistrokeRecognizer::makeSwipeTemplate(
+        Direction direction,
+        double dx,
+        double dy) {
+    // A straight stroke resamples to equidistant points, keeps its base orientation, scales to span
+    // DIAGONAL and is centered on the origin, so its normalized form can be written down directly
+    GestureTemplate result{};
+    result.direction = direction;
+    double sum = 0.0;
+    for (int i = 0; i < NUM_POINTS; i++) {
+        double offset = DIAGONAL * i / (NUM_POINTS - 1) - HALF_DIAGONAL;
+        result.points.x[i] = dx * offset;
+        result.points.y[i] = dy * offset;
+        result.radius[i] = offset < 0.0 ? -offset : offset;
+        result.coarseRadius[i / (NUM_POINTS / GestureTemplate::COARSE_BINS)] += result.radius[i];
+        sum += offset * offset;
+    }
+    result.points.count = NUM_POINTS;
+
+    for (int i = 0; i < PREFILTER_POINTS; i++) {
+        result.prefilterPoints.x[i] = result.points.x[prefilterSourceIndex(i)];
+        result.prefilterPoints.y[i] = result.points.y[prefilterSourceIndex(i)];
+    }
+    result.prefilterPoints.count = PREFILTER_POINTS;
+
+    // Same unit-length vector vectorize() would produce
+    double magnitude = constexprSqrt(sum);
+    for (int i = 0; i < NUM_POINTS; i++) {
+        result.vector.x[i] = result.points.x[i] / magnitude;
+        result.vector.y[i] = result.points.y[i] / magnitude;
+    }
+    result.vector.count = NUM_POINTS;
+    return result;
+}
+
+// constexpr enforces constant initialization, so the templates are never built at runtime and live in
+// read-only memory
+constexpr UnistrokeRecognizer::GestureTemplate UnistrokeRecognizer::s_templates[4] = {
+        makeSwipeTemplate(Direction::Right, 1.0, 0.0),  // Right swipe (from left to right)
+        makeSwipeTemplate(Direction::Left, -1.0, 0.0),  // Left swipe (from right to left)
+        makeSwipeTemplate(Direction::Down, 0.0, 1.0),   // Down swipe (from top to bottom)
+        makeSwipeTemplate(Direction::Up, 0.0, -1.0)     // Up swipe (from bottom to top)
+};
+
+UnistrokeRecognizer::UnistrokeRecognizer(Matcher matcher) :
+        m_workspace(),
+        m_library(nullptr),
+        m_matcher(matcher),
+        m_searchStages(ALL_SEARCH_STAGES),
+        m_searchStats(),
+        m_streaming(false),
+        m_streamPoints(),
+        m_streamLast(),
+        m_streamStep(STREAM_INITIAL_STEP),
+        m_streamCarry(0.0),
+        m_strokeStarted(false),
+        m_streamComplete(true) {
+    m_streamPoints.reserve(STREAM_CAPACITY);
+    m_workspace.ranking.reserve(std::size(s_templates));
+}
+
+void UnistrokeRecognizer::reset() {
+    m_workspace.candidate.clear();
+    m_streamPoints.clear();
+    m_streamStep = STREAM_INITIAL_STEP;
+    m_streamCarry = 0.0;
+    m_strokeStarted = false;
+    m_streamComplete = true;
+}
+
+void UnistrokeRecognizer::addPoint(int32_t x, int32_t y) {
+    m_strokeStarted = true;
+    if (m_streaming) {
+        streamPosition(Point(static_cast<double>(x), static_cast<double>(y)));
+    }
+}
+
+bool UnistrokeRecognizer::prepareCandidate(const Positions& positions) const {
+    if (positions.size() < 3) {  // Need at least 3 points for recognition
+        return false;
+    }
+
+    GesturePath& candidate = m_workspace.candidate;
+    if (m_streaming && m_streamComplete && !m_streamPoints.empty()) {
+        // The stroke has already been resampled while it was drawn
+        resampleStream(NUM_POINTS, candidate);
+    } else {
+        resample(positions, NUM_POINTS, candidate);
+    }
+
+    // Process the gesture using $1 Unistroke Recognizer
+    normalize(candidate);
+    return true;
+}
+
+UnistrokeRecognizer::Direction UnistrokeRecognizer::recognize(const Positions& positions) const {
+    if (!prepareCandidate(positions)) {
+        return Direction::None;
+    }
+
+    // Only distances below the recognition threshold are accepted, so the threshold is the initial bound
+    // templates have to beat
+    double bestDistance = (m_matcher == Matcher::Protractor) ? PROTRACTOR_THRESHOLD : UNISTROKE_THRESHOLD;
+    const GestureTemplate* bestTemplate = matchCandidate(bestDistance);
+    return bestTemplate ? bestTemplate->direction : Direction::None;
+}
+
+double UnistrokeRecognizer::closestTemplate(const Positions& positions, Direction& direction) const {
+    direction = Direction::None;
+    double bestDistance = std::numeric_limits<double>::infinity();
+    if (!prepareCandidate(positions)) {
+        return bestDistance;
+    }
+    if (const GestureTemplate* bestTemplate = matchCandidate(bestDistance)) {
+        direction = bestTemplate->direction;
+    }
+    return bestDistance;
+}
+
+const UnistrokeRecognizer::GestureTemplate* UnistrokeRecognizer::matchCandidate(double& bestDistance) const {
+    const GesturePath& candidate = m_workspace.candidate;
+    const GestureTemplate* bestTemplate = nullptr;
+
+    if (m_matcher == Matcher::Protractor) {
+        vectorize(candidate, m_workspace.vector);
+        forEachTemplate([&](const GestureTemplate& candidateTemplate) {
+            double distance = optimalCosineDistance(m_workspace.vector, candidateTemplate.vector);
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                bestTemplate = &candidateTemplate;
+            }
+        });
+    } else {
+        radiusProfile(candidate, m_workspace.radius, m_workspace.coarseRadius);
+        subsample(candidate, m_workspace.prefilter);
+        m_workspace.ranking.clear();
+        forEachTemplate([this](const GestureTemplate& candidateTemplate) {
+            m_workspace.ranking.push_back({coarseBound(candidateTemplate), &candidateTemplate});
+        });
+        m_searchStats.recognitions++;
+        m_searchStats.templates += m_workspace.ranking.size();
+        searchRankedTemplates(bestDistance, bestTemplate);
+    }
+    return bestTemplate;
+}
+
+bool UnistrokeRecognizer::isUsable(const GestureTemplate& gestureTemplate) {
+    return gestureTemplate.points.count == NUM_POINTS && gestureTemplate.vector.count == NUM_POINTS &&
+           gestureTemplate.prefilterPoints.count == PREFILTER_POINTS;
+}
+
+// Template index. Candidate and templates are centered on their centroid and the golden-section search
+// rotates about it, which leaves the distance of every point from the centroid unchanged. By the triangle
+// inequality |R(c) - t| >= ||c| - |t||, so the mean radius difference bounds the distance at every angle,
+// and summing runs of radii before taking the difference gives a cheaper, weaker bound.
+void UnistrokeRecognizer::radiusProfile(const GesturePath& points, double* radius, double* coarseRadius) const {
+    const size_t binSize = points.size() / GestureTemplate::COARSE_BINS;
+    std::fill(coarseRadius, coarseRadius + GestureTemplate::COARSE_BINS, 0.0);
+    for (size_t i = 0; i < points.size(); i++) {
+        radius[i] = std::sqrt(points.x[i] * points.x[i] + points.y[i] * points.y[i]);
+        coarseRadius[i / binSize] += radius[i];
+    }
+}
+
+double UnistrokeRecognizer::coarseBound(const GestureTemplate& gestureTemplate) const {
+    double sum = 0.0;
+    for (size_t bin = 0; bin < GestureTemplate::COARSE_BINS; bin++) {
+        sum += std::abs(m_workspace.coarseRadius[bin] - gestureTemplate.coarseRadius[bin]);
+    }
+    return sum / NUM_POINTS;
+}
+
+double UnistrokeRecognizer::radiusBound(const GestureTemplate& gestureTemplate) const {
+    double sum = 0.0;
+    for (int i = 0; i < NUM_POINTS; i++) {
+        sum += std::abs(m_workspace.radius[i] - gestureTemplate.radius[i]);
+    }
+    return sum / NUM_POINTS;
+}
+
+void UnistrokeRecognizer::searchRankedTemplates(double& bestDistance, const GestureTemplate*& bestTemplate) const {
+    // Visit templates from the most promising coarse bound, so a close match is found early and prunes the rest
+    auto& ranking = m_workspace.ranking;
+    auto isFartherThan = [](const RankedTemplate& a, const RankedTemplate& b) {
+        return a.bound > b.bound;
+    };
+    std::make_heap(ranking.begin(), ranking.end(), isFartherThan);
+    const bool useBounds = (m_searchStages & RADIUS_BOUNDS) != 0;
+    const bool usePrefilter = (m_searchStages & PREFILTER) != 0;
+
+    for (auto end = ranking.end(); end != ranking.begin(); --end) {
+        std::pop_heap(ranking.begin(), end, isFartherThan);
+        const RankedTemplate& entry = *(end - 1);
+        if (useBounds && entry.bound >= bestDistance) {
+            break;  // Bounds only grow from here on
+        }
+        const GestureTemplate& candidateTemplate = *entry.gestureTemplate;
+        if (useBounds && radiusBound(candidateTemplate) >= bestDistance) {
+            continue;
+        }
+
+        // Coarse-to-fine: the low-resolution distance closely tracks the full one at a quarter of the cost,
+        // so only templates it puts within a margin of the best distance are matched at full resolution
+        if (usePrefilter) {
+            m_searchStats.prefilterSearches++;
+            double prefilterDistance = distanceAtBestAngle(m_workspace.prefilter, candidateTemplate.prefilterPoints);
+            if (prefilterDistance >= bestDistance + PREFILTER_MARGIN) {
+                continue;
+            }
+        }
+
+        m_searchStats.fullSearches++;
+        double distance = distanceAtBestAngle(m_workspace.candidate, candidateTemplate.points);
+        if (distance < bestDistance) {
+            bestDistance = distance;
+            bestTemplate = &candidateTemplate;
+        }
+    }
+}
+
+void UnistrokeRecognizer::subsample(const GesturePath& points, GesturePath& prefilterPoints) const {
+    // The points are equidistant along the stroke, so an evenly spaced subset is a coarser resampling
+    for (int i = 0; i < PREFILTER_POINTS; i++) {
+        prefilterPoints.x[i] = points.x[prefilterSourceIndex(i)];
+        prefilterPoints.y[i] = points.y[prefilterSourceIndex(i)];
+    }
+    prefilterPoints.count = PREFILTER_POINTS;
+}
+
+void UnistrokeRecognizer::setStreaming(bool streaming) {
+    m_streaming = streaming;
+    // A stroke in progress is resampled in batch; streaming covers strokes started from here on
+    m_streamComplete = !m_strokeStarted;
+    m_streamPoints.clear();
+    m_streamStep = STREAM_INITIAL_STEP;
+    m_streamCarry = 0.0;
+}
+
+void UnistrokeRecognizer::setSearchStages(uint32_t stages) {
+    m_searchStages = stages;
+}
+
+void UnistrokeRecognizer::setTemplateLibrary(const GestureLibrary* library) {
+    m_library = library;
+    // Make room for every template now, so recognize() never grows the ranking; a library that grows later
+    // is handed to a new recognizer
+    m_workspace.ranking.reserve(std::size(s_templates) + (library ? library->size() : 0));
+}
+
+bool UnistrokeRecognizer::createTemplate(
+        const Positions& positions,
+        Direction direction,
+        GestureTemplate& result) const {
+    if (positions.size() < 2) {
+        return false;
+    }
+
+    // Templates always resample the full stroke, independent of the streaming mode
+    result = GestureTemplate{};
+    result.direction = direction;
+    resample(positions, NUM_POINTS, result.points);
+    normalize(result.points);
+    vectorize(result.points, result.vector);
+    subsample(result.points, result.prefilterPoints);
+    radiusProfile(result.points, result.radius, result.coarseRadius);
+    return true;
+}
+
+
+// Streaming resampler methods
+void UnistrokeRecognizer::streamPosition(const Point& p) {
+    if (m_streamPoints.empty()) {
+        m_streamPoints.push_back(p);
+        m_streamLast = p;
+        return;
+    }
+
+    // Emit a point every m_streamStep along the new segment, carrying the leftover length to the next one
+    Point from = m_streamLast;
+    double remaining = distance(from, p);
+    while (m_streamCarry + remaining >= m_streamStep) {
+        double advance = m_streamStep - m_streamCarry;
+        from = from + (p - from) * (advance / remaining);
+        remaining -= advance;
+        m_streamCarry = 0.0;
+        emitStreamPoint(from);
+    }
+    m_streamCarry += remaining;
+    m_streamLast = p;
+}
+
+void UnistrokeRecognizer::emitStreamPoint(const Point& p) {
+    m_streamPoints.push_back(p);
+    if (m_streamPoints.size() < static_cast<size_t>(STREAM_CAPACITY)) {
+        return;
+    }
+
+    // Buffer is full: keep every other point and double the spacing. STREAM_CAPACITY is even, so the
+    // point just emitted is dropped and the distance to it becomes carry.
+    size_t kept = 0;
+    for (size_t i = 0; i < m_streamPoints.size(); i += 2) {
+        m_streamPoints[kept++] = m_streamPoints[i];
+    }
+    m_streamPoints.resize(kept);
+    m_streamCarry += m_streamStep;
+    m_streamStep *= 2.0;
+}
+
+void UnistrokeRecognizer::resampleStream(int n, GesturePath& newPoints) const {
+    // The streamed points are equidistant, so each resampled point is found by index arithmetic
+    // instead of walking the stroke. The tail runs from the last streamed point to the latest position.
+    const Point& tail = m_streamPoints.back();
+    const size_t count = m_streamPoints.size();
+    double streamedLength = (count - 1) * m_streamStep;
+    double tailLength = distance(tail, m_streamLast);
+    double interval = (streamedLength + tailLength) / (n - 1);
+
+    newPoints.clear();
+    for (int i = 0; i < n; i++) {
+        double d = i * interval;
+        if (d < streamedLength) {
+            double position = d / m_streamStep;
+            size_t index = std::min(static_cast<size_t>(position), count - 2);
+            double ratio = position - static_cast<double>(index);
+            newPoints.push_back(m_streamPoints[index] + (m_streamPoints[index + 1] - m_streamPoints[index]) * ratio);
+        } else if (tailLength > 0.0) {
+            double ratio = std::min(1.0, (d - streamedLength) / tailLength);
+            newPoints.push_back(tail + (m_streamLast - tail) * ratio);
+        } else {
+            newPoints.push_back(tail);
+        }
+    }
+}
+
+// $1 Unistroke Recognizer helper methods
+namespace {
+Point toPoint(const std::pair<int32_t, int32_t>& p) {
+    return Point(static_cast<double>(p.first), static_cast<double>(p.second));
+}
+}  // namespace
+
+void UnistrokeRecognizer::resample(const Positions& points, int n, GesturePath& newPoints) const {
+    newPoints.clear();
+    if (points.empty())
+        return;
+
+    Point previous = toPoint(points[0]);
+    Point last = toPoint(points.back());
+    if (points.size() == 1) {
+        while (newPoints.size() < static_cast<size_t>(n)) {
+            newPoints.push_back(previous);  // If only one point, duplicate it
+        }
+        return;
+    }
+
+    double length = 0.0;
+    for (size_t i = 1; i < points.size(); i++) {
+        length += distance(toPoint(points[i - 1]), toPoint(points[i]));
+    }
+    double interval = length / (n - 1);
+    newPoints.push_back(previous);  // Start with the first point
+
+    // Each emitted point becomes the start of the remaining segment, so long segments yield several points
+    double accumulatedDistance = 0.0;  // Accumulated distance
+    size_t currentPointIndex = 1;
+
+    while (newPoints.size() < static_cast<size_t>(n) && currentPointIndex < points.size()) {
+        Point current = toPoint(points[currentPointIndex]);
+        double segment = distance(previous, current);
+        if (segment > 0.0 && (accumulatedDistance + segment) >= interval) {
+            double ratio = (interval - accumulatedDistance) / segment;
+            Point q = previous + (current - previous) * ratio;
+            newPoints.push_back(q);
+            previous = q;
+            accumulatedDistance = 0.0;  // Reset distance accumulator
+        } else {
+            accumulatedDistance += segment;
+            previous = current;
+            currentPointIndex++;
+        }
+    }
+
+    // Sometimes we don't get quite enough points, so add the last point
+    while (newPoints.size() < static_cast<size_t>(n)) {
+        newPoints.push_back(last);
+    }
+}
+
+double UnistrokeRecognizer::indicativeAngle(const GesturePath& points) const {
+    if (points.empty())
+        return 0.0;
+
+    Point c = centroid(points);
+    return std::atan2(c.y - points.y[0], c.x - points.x[0]);
+}
+
+double UnistrokeRecognizer::alignmentAngle(const GesturePath& points) const {
+    // Rotating all the way to zero would make every straight swipe look the same, so keep the
+    // stroke's orientation and only snap it to the nearest of the eight base orientations
+    const double baseOrientation = M_PI / 4.0;
+    double angle = indicativeAngle(points);
+    return std::round(angle / baseOrientation) * baseOrientation - angle;
+}
+
+void UnistrokeRecognizer::rotateBy(GesturePath& points, double radians) const {
+    rotateInto(points, radians, points);
+}
+
+void UnistrokeRecognizer::rotateInto(const GesturePath& points, double radians, GesturePath& rotatedPoints) const {
+    Point c = centroid(points);
+    gestureKernels().rotate(
+            points.x,
+            points.y,
+            points.size(),
+            std::cos(radians),
+            std::sin(radians),
+            c.x,
+            c.y,
+            rotatedPoints.x,
+            rotatedPoints.y);
+    rotatedPoints.count = points.count;
+}
+
+void UnistrokeRecognizer::scaleTo(GesturePath& points, double size) const {
+    // Calculate the bounding box
+    if (points.empty())
+        return;
+
+    PathBounds bounds = gestureKernels().bounds(points.x, points.y, points.size());
+    double w = bounds.maxX - bounds.minX;
+    double h = bounds.maxY - bounds.minY;
+
+    // Maintain aspect ratio by using the maximum dimension
+    double scale = (w > h) ? size / w : size / h;
+
+    for (size_t i = 0; i < points.size(); i++) {
+        points.x[i] *= scale;
+        points.y[i] *= scale;
+    }
+}
+
+void UnistrokeRecognizer::translateTo(GesturePath& points, Point origin) const {
+    Point c = centroid(points);
+    for (size_t i = 0; i < points.size(); i++) {
+        points.x[i] += origin.x - c.x;
+        points.y[i] += origin.y - c.y;
+    }
+}
+
+void UnistrokeRecognizer::normalize(GesturePath& points) const {
+    rotateBy(points, alignmentAngle(points));
+    scaleTo(points, DIAGONAL);
+    translateTo(points, Point(0, 0));
+}
+
+double UnistrokeRecognizer::distanceAtAngle(
+        const GesturePath& points,
+        const GesturePath& templatePoints,
+        double radians,
+        double limit) const {
+    rotateInto(points, radians, m_workspace.rotated);
+    return pathDistance(m_workspace.rotated, templatePoints, limit);
+}
+
+double UnistrokeRecognizer::distanceAtBestAngle(const GesturePath& points, const GesturePath& templatePoints) const {
+    // Convert angles from degrees to radians
+    double degToRad = M_PI / 180.0;
+    double angle1 = -ANGLE_RANGE * degToRad;
+    double angle2 = ANGLE_RANGE * degToRad;
+    // Each new probe is only compared with the other one, so its distance is abandoned as soon as it exceeds
+    // that value; abandoned probes are always the ones discarded, and the search path stays exact
+    const double noLimit = std::numeric_limits<double>::infinity();
+    const bool abandon = (m_searchStages & EARLY_ABANDON) != 0;
+    double x1 = PHI * angle1 + (1.0 - PHI) * angle2;
+    double f1 = distanceAtAngle(points, templatePoints, x1, noLimit);
+    double x2 = (1.0 - PHI) * angle1 + PHI * angle2;
+    double f2 = distanceAtAngle(points, templatePoints, x2, abandon ? f1 : noLimit);
+
+    double precisionRad = ANGLE_PRECISION * degToRad;  // Convert precision to radians too
+
+    while (std::abs(angle2 - angle1) > precisionRad) {
+        if (f1 < f2) {
+            angle2 = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = PHI * angle1 + (1.0 - PHI) * angle2;
+            f1 = distanceAtAngle(points, templatePoints, x1, abandon ? f2 : noLimit);
+        } else {
+            angle1 = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = (1.0 - PHI) * angle1 + PHI * angle2;
+            f2 = distanceAtAngle(points, templatePoints, x2, abandon ? f1 : noLimit);
+        }
+    }
+
+    return std::min(f1, f2);
+}
+
+double UnistrokeRecognizer::pathDistance(const GesturePath& pts1, const GesturePath& pts2, double limit) const {
+    if (pts1.size() != pts2.size())
+        return std::numeric_limits<double>::max();
+
+    // Distances beyond limit are reported as infinity, whether or not the kernel stopped early
+    double sumLimit = limit * pts1.size();
+    double sum = gestureKernels().pathDistance(pts1.x, pts1.y, pts2.x, pts2.y, pts1.size(), sumLimit);
+    return sum > sumLimit ? std::numeric_limits<double>::infinity() : sum / pts1.size();
+}
+
+Point UnistrokeRecognizer::centroid(const GesturePath& points) const {
+    if (points.empty())
+        return Point(0, 0);
+
+    double x = 0.0, y = 0.0;
+    gestureKernels().coordinateSum(points.x, points.y, points.size(), x, y);
+    return Point(x / points.size(), y / points.size());
+}
+
+double UnistrokeRecognizer::distance(const Point& p1, const Point& p2) const {
+    double dx = p2.x - p1.x;
+    double dy = p2.y - p1.y;
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+// Protractor helper methods
+void UnistrokeRecognizer::vectorize(const GesturePath& points, GesturePath& vector) const {
+    // Points are already centered on the origin and rotated to their base orientation,
+    // so the vector only needs to be normalized to unit length
+    double sum = 0.0;
+    for (size_t i = 0; i < points.size(); i++) {
+        sum += points.x[i] * points.x[i] + points.y[i] * points.y[i];
+    }
+
+    double magnitude = std::sqrt(sum);
+    double scale = (magnitude > 0.0) ? 1.0 / magnitude : 1.0;
+    for (size_t i = 0; i < points.size(); i++) {
+        vector.x[i] = points.x[i] * scale;
+        vector.y[i] = points.y[i] * scale;
+    }
+    vector.count = points.count;
+}
+
+double UnistrokeRecognizer::optimalCosineDistance(const GesturePath& vector1, const GesturePath& vector2) const {
+    if (vector1.size() != vector2.size())
+        return std::numeric_limits<double>::max();
+
+    // a and b are the dot products of vector1 with vector2 and with vector2 rotated by 90 degrees;
+    // the rotation maximizing a * cos(angle) + b * sin(angle) is atan2(b, a)
+    double a = 0.0;
+    double b = 0.0;
+    for (size_t i = 0; i < vector1.size(); i++) {
+        a += vector1.x[i] * vector2.x[i] + vector1.y[i] * vector2.y[i];
+        b += vector1.y[i] * vector2.x[i] - vector1.x[i] * vector2.y[i];
+    }
+
+    // Limit the rotation to the same range the golden-section search explores
+    double maxAngle = ANGLE_RANGE * M_PI / 180.0;
+    double angle = std::clamp(std::atan2(b, a), -maxAngle, maxAngle);
+    double similarity = a * std::cos(angle) + b * std::sin(angle);
+    return std::acos(std::clamp(similarity, -1.0, 1.0));
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,230 @@
+#pragma once
+#include "IGestureRecognizer.h"
+#include "GestureLibrary.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief $1 Unistroke Recognizer matching strokes against the built-in and user-recorded templates
+ */
+class UnistrokeRecognizer : public IGestureRecognizer {
+public:
+    using GestureTemplate = GestureAnalyzer::GestureTemplate;
+
+    /**
+     * @brief Template matching engines for the $1 Unistroke Recognizer
+     */
+    enum class Matcher {
+        GoldenSection,  // Golden-section search over rotations (original $1)
+        Protractor      // Closed-form optimal rotation and cosine distance
+    };
+
+    /**
+     * @brief Stages of the golden-section search that skip work, combined as flags
+     */
+    enum SearchStage : uint32_t {
+        RADIUS_BOUNDS = 1 << 0,  // Visit templates by their rotation-invariant bound and skip those that cannot win
+        EARLY_ABANDON = 1 << 1,  // Stop summing a probe's distance once it exceeds the one it is compared with
+        PREFILTER = 1 << 2,      // Only match templates at full resolution that are close at low resolution
+        ALL_SEARCH_STAGES = RADIUS_BOUNDS | EARLY_ABANDON | PREFILTER
+    };
+
+    /**
+     * @brief Work done by the golden-section search since the recognizer was created
+     */
+    struct SearchStats {
+        uint64_t recognitions = 0;       // Strokes matched against the templates
+        uint64_t templates = 0;          // Templates those strokes were matched against
+        uint64_t fullSearches = 0;       // Searches over rotations at full resolution
+        uint64_t prefilterSearches = 0;  // Searches over rotations of the low-resolution paths
+    };
+
+    explicit UnistrokeRecognizer(Matcher matcher = Matcher::GoldenSection);
+
+    void reset() override;
+    void addPoint(int32_t x, int32_t y) override;
+    Direction recognize(const Positions& positions) const override;
+    void setTemplateLibrary(const GestureLibrary* library) override;
+
+    /**
+     * @brief Enables incremental resampling of the stroke while positions are added
+     * @param streaming true to resample in addPoint so recognition costs constant time,
+     *                  false to resample the whole stroke when it is recognized; a stroke in progress
+     *                  is resampled in batch
+     */
+    void setStreaming(bool streaming);
+
+    /**
+     * @brief Finds the closest template without applying the recognition threshold
+     * @param positions Positions of the stroke
+     * @param direction Receives the direction of the closest template, None if the stroke is too short
+     * @return Distance to that template: the mean point distance for the golden-section matcher, the angle in
+     *         radians for Protractor; infinity if the stroke is too short
+     */
+    double closestTemplate(const Positions& positions, Direction& direction) const;
+
+    /**
+     * @brief Selects the stages of the golden-section search; all of them are on by default
+     *
+     * The bounds and early abandoning only skip work that cannot change the result, and the prefilter margin is
+     * wide enough not to change it in practice, so turning stages off is meant for measuring what they save.
+     *
+     * @param stages Combination of SearchStage flags
+     */
+    void setSearchStages(uint32_t stages);
+
+    /**
+     * @brief Returns the work done by the golden-section search so far
+     */
+    const SearchStats& searchStats() const {
+        return m_searchStats;
+    }
+
+    /**
+     * @brief Preprocesses a stroke into a template for the given direction
+     * @param positions Positions of the stroke
+     * @param direction Direction the stroke stands for
+     * @param result Receives the normalized template
+     * @return true if the stroke has enough positions to build a template
+     */
+    bool createTemplate(const Positions& positions, Direction direction, GestureTemplate& result) const;
+
+protected:
+    // $1 Unistroke Recognizer constants
+    static constexpr int NUM_POINTS = 64;           // Number of points to resample each gesture to
+    static constexpr double ANGLE_RANGE = 45.0;     // Angle range for rotation in degrees
+    static constexpr double ANGLE_PRECISION = 2.0;  // Angle precision for search in degrees
+    static constexpr double DIAGONAL = 250.0;       // Square root of 250^2 + 250^2 (bounding box size)
+    static constexpr double HALF_DIAGONAL = 125.0;  // Half of the diagonal
+    static constexpr double PHI = 0.618033988;      // Golden ratio - 1 (0.5 * (-1.0 + std::sqrt(5.0)) calculated)
+    static constexpr double UNISTROKE_THRESHOLD = 150.0;  // Max path distance accepted by the golden-section matcher
+    // Max angular distance (radians) accepted by Protractor: pi / 2, which like UNISTROKE_THRESHOLD rejects no
+    // stroke. Every built-in template has its opposite, so the closest one is never more than pi / 2 away.
+    static constexpr double PROTRACTOR_THRESHOLD = 1.5707963267948966;
+
+    // Coarse-to-fine cascade constants
+    static constexpr int PREFILTER_POINTS = 16;       // Points of the low-resolution paths matched first
+    static constexpr double PREFILTER_MARGIN = 10.0;  // Prefilter distance above the best one still matched in full
+
+    // Streaming resampler constants
+    static constexpr int STREAM_CAPACITY = 4 * NUM_POINTS;  // Max equidistant points kept while streaming
+    static constexpr double STREAM_INITIAL_STEP = 1.0;      // Initial spacing of streamed points in pixels
+
+    static_assert(NUM_POINTS <= GesturePath::CAPACITY, "Resampled gestures must fit in a GesturePath");
+    static_assert(NUM_POINTS % GestureTemplate::COARSE_BINS == 0, "Coarse bins must cover equal runs of points");
+
+    // Resamples and normalizes the stroke into the workspace candidate; false if it is too short to recognize
+    bool prepareCandidate(const Positions& positions) const;
+
+    // Returns the candidate prepared by prepareCandidate()
+    const GesturePath& candidate() const {
+        return m_workspace.candidate;
+    }
+
+    // Calls visit for every usable built-in and user-recorded template
+    template <typename Visitor>
+    void forEachTemplate(Visitor&& visit) const {
+        for (const GestureTemplate& gestureTemplate : s_templates) {
+            visit(gestureTemplate);
+        }
+        if (m_library) {
+            const GestureTemplate* templates = m_library->templates();
+            for (size_t i = 0; i < m_library->size(); ++i) {
+                // Library files are used in place, so skip records that were not built with this resampling
+                if (isUsable(templates[i])) {
+                    visit(templates[i]);
+                }
+            }
+        }
+    }
+
+    double distance(const Point& p1, const Point& p2) const;
+
+private:
+    // A template with the lower bound of its distance to the current candidate
+    struct RankedTemplate {
+        double bound;
+        const GestureTemplate* gestureTemplate;
+    };
+
+    // Buffers the recognizer transforms in place, so recognizing a gesture does no heap allocation
+    struct Workspace {
+        GesturePath candidate;                              // Resampled and normalized stroke
+        GesturePath rotated;                                // Candidate rotated during the golden-section search
+        GesturePath vector;                                 // Candidate normalized to unit length for Protractor
+        GesturePath prefilter;                              // Low-resolution subset of the candidate
+        alignas(32) double radius[GesturePath::CAPACITY];   // Radius profile of the candidate
+        double coarseRadius[GestureTemplate::COARSE_BINS];  // Coarse radius profile of the candidate
+        std::vector<RankedTemplate> ranking;                // Templates ordered by their coarse bound
+    };
+
+    mutable Workspace m_workspace;
+    static const GestureTemplate s_templates[4];  // Predefined gesture templates, constant-initialized
+    const GestureLibrary* m_library;              // User-recorded templates, if any
+    Matcher m_matcher;                            // Template matching engine
+    uint32_t m_searchStages;                      // SearchStage flags of the golden-section search
+    mutable SearchStats m_searchStats;
+
+    // Streaming resampler state: equidistant points along the stroke, decimated by half whenever the
+    // buffer fills so that memory and the work left for recognition stay bounded
+    bool m_streaming;
+    std::vector<Point> m_streamPoints;  // Points spaced m_streamStep apart along the stroke
+    Point m_streamLast;                 // Most recent raw position
+    double m_streamStep;                // Current spacing between streamed points
+    double m_streamCarry;               // Path length travelled since the last streamed point
+    bool m_strokeStarted;               // Points were added since the last reset
+    bool m_streamComplete;              // The stream covers the whole stroke since the last reset
+
+    // $1 Unistroke Recognizer methods
+    void resample(const Positions& points, int n, GesturePath& newPoints) const;
+    double indicativeAngle(const GesturePath& points) const;
+    double alignmentAngle(const GesturePath& points) const;
+    void rotateBy(GesturePath& points, double radians) const;
+    void rotateInto(const GesturePath& points, double radians, GesturePath& rotatedPoints) const;
+    void scaleTo(GesturePath& points, double size) const;
+    void translateTo(GesturePath& points, Point origin) const;
+    void normalize(GesturePath& points) const;
+    double distanceAtAngle(
+            const GesturePath& points,
+            const GesturePath& templatePoints,
+            double radians,
+            double limit) const;
+    double distanceAtBestAngle(const GesturePath& points, const GesturePath& templatePoints) const;
+    double pathDistance(const GesturePath& pts1, const GesturePath& pts2, double limit) const;
+    Point centroid(const GesturePath& points) const;
+
+    // Protractor methods
+    void vectorize(const GesturePath& points, GesturePath& vector) const;
+    double optimalCosineDistance(const GesturePath& vector1, const GesturePath& vector2) const;
+
+    // Streaming resampler methods
+    void streamPosition(const Point& p);
+    void emitStreamPoint(const Point& p);
+    void resampleStream(int n, GesturePath& newPoints) const;
+
+    // Builds the normalized template of a straight swipe along (dx, dy) at compile time
+    static constexpr GestureTemplate makeSwipeTemplate(Direction direction, double dx, double dy);
+
+    // Whether a library record was built with the current resampling
+    static bool isUsable(const GestureTemplate& gestureTemplate);
+
+    // Template index: rotation-invariant lower bounds of the golden-section distance
+    void radiusProfile(const GesturePath& points, double* radius, double* coarseRadius) const;
+    double coarseBound(const GestureTemplate& gestureTemplate) const;
+    double radiusBound(const GestureTemplate& gestureTemplate) const;
+    void searchRankedTemplates(double& bestDistance, const GestureTemplate*& bestTemplate) const;
+
+    // Matches the prepared candidate; returns the closest template below bestDistance and lowers it to its distance
+    const GestureTemplate* matchCandidate(double& bestDistance) const;
+
+    // Coarse-to-fine cascade: index of the full-resolution point each prefilter point is taken from
+    static constexpr int prefilterSourceIndex(int i) {
+        return (i * (NUM_POINTS - 1) + (PREFILTER_POINTS - 1) / 2) / (PREFILTER_POINTS - 1);
+    }
+    void subsample(const GesturePath& points, GesturePath& prefilterPoints) const;
+};
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,141 @@
+#include "WorkerPool.h"
+#include <algorithm>
+#include <system_error>
+
+namespace VirtualDesktop {
+
+WorkerPool::WorkerPool() :
+        m_threadCount(1),
+        m_bands(std::make_unique<Band[]>(MAX_THREADS)),
+        m_job(nullptr),
+        m_generation(0),
+        m_pending(0),
+        m_stopping(false) {
+    setThreads(0);
+}
+
+WorkerPool::~WorkerPool() {
+    stop();
+}
+
+void WorkerPool::setThreads(unsigned threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, MAX_THREADS);
+    if (threads != m_threadCount) {
+        stop();
+        m_threadCount = threads;
+    }
+}
+
+void WorkerPool::run(size_t count, const std::function<void(size_t)>& job) {
+    if (m_threadCount <= 1 || count <= 1) {
+        for (size_t i = 0; i < count; ++i) {
+            job(i);
+        }
+        return;
+    }
+    if (m_workers.empty()) {
+        start();
+    }
+
+    // Contiguous bands of near-equal size; the bands of workers that could not be started are stolen
+    for (unsigned band = 0; band < m_threadCount; ++band) {
+        m_bands[band].next.store(count * band / m_threadCount, std::memory_order_relaxed);
+        m_bands[band].end = count * (band + 1) / m_threadCount;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = &job;
+        m_pending = static_cast<unsigned>(m_workers.size());
+        ++m_generation;
+    }
+    m_wake.notify_all();
+
+    work(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] {
+        return m_pending == 0;
+    });
+    m_job = nullptr;
+}
+
+void WorkerPool::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_workers.empty()) {
+            return;
+        }
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    m_stopping = false;
+}
+
+void WorkerPool::start() {
+    // No worker exists yet, so the generation cannot change under them before they wait for the next one
+    const uint64_t generation = m_generation;
+    try {
+        for (unsigned band = 1; band < m_threadCount; ++band) {
+            m_workers.emplace_back(&WorkerPool::workerLoop, this, band, generation);
+        }
+    } catch (const std::system_error&) {
+        // Run with the workers that did start
+    }
+}
+
+void WorkerPool::workerLoop(unsigned band, uint64_t generation) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_wake.wait(lock, [this, generation] {
+            return m_stopping || m_generation != generation;
+        });
+        if (m_stopping) {
+            return;
+        }
+        generation = m_generation;
+
+        lock.unlock();
+        work(band);
+        lock.lock();
+        if (--m_pending == 0) {
+            m_done.notify_one();
+        }
+    }
+}
+
+void WorkerPool::work(unsigned band) {
+    const std::function<void(size_t)>& job = *m_job;
+    for (;;) {
+        Band* from = &m_bands[band];
+        size_t item = from->next.fetch_add(1, std::memory_order_relaxed);
+        if (item >= from->end) {
+            // Own band exhausted: steal from the band with the most items left
+            from = nullptr;
+            size_t most = 0;
+            for (unsigned other = 0; other < m_threadCount; ++other) {
+                size_t next = m_bands[other].next.load(std::memory_order_relaxed);
+                if (next < m_bands[other].end && m_bands[other].end - next > most) {
+                    most = m_bands[other].end - next;
+                    from = &m_bands[other];
+                }
+            }
+            if (!from) {
+                return;
+            }
+            item = from->next.fetch_add(1, std::memory_order_relaxed);
+            if (item >= from->end) {
+                continue;
+            }
+        }
+        job(item);
+    }
+}
+
+}  // namespace VirtualDesktop
@@ -0,0 +1,83 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace VirtualDesktop {
+
+/**
+ * @brief Small persistent thread pool that runs one parallel loop at a time, balanced by work stealing
+ *
+ * run() splits the items into one contiguous band per thread, the calling thread included. Each thread takes
+ * items from the front of its own band and, once that is empty, steals from the band with the most items left,
+ * so bands of uneven cost still finish together. Worker threads start on the first run() that needs them and
+ * sleep between runs until stop() ends them.
+ */
+class WorkerPool {
+public:
+    static constexpr unsigned MAX_THREADS = 8;
+
+    WorkerPool();
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    /**
+     * @brief Sets the number of threads run() uses, the calling thread included
+     * @param threads 1 runs everything on the calling thread; 0 picks the hardware concurrency, capped
+     */
+    void setThreads(unsigned threads);
+
+    unsigned threads() const {
+        return m_threadCount;
+    }
+
+    /**
+     * @brief Calls job(i) for every i in [0, count) and returns once all calls returned
+     *
+     * Calls for different items may run concurrently; each item is handled exactly once.
+     */
+    void run(size_t count, const std::function<void(size_t)>& job);
+
+    /**
+     * @brief Ends the worker threads; the next run() that needs them starts them again
+     */
+    void stop();
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Items [next, end) not taken yet; next may run past end once the band is exhausted. Padded rather than
+    // over-aligned, so threads taking items from neighbouring bands do not share a cache line.
+    struct Band {
+        std::atomic<size_t> next;
+        size_t end;
+        char padding[CACHE_LINE - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    };
+
+    void start();
+    // Waits for runs after the given generation and works on the given band in each
+    void workerLoop(unsigned band, uint64_t generation);
+    // Handles items of the given band, then steals from the others until all are exhausted
+    void work(unsigned band);
+
+    unsigned m_threadCount;
+    std::unique_ptr<Band[]> m_bands;  // One per thread, the caller's first
+    const std::function<void(size_t)>* m_job;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;  // Workers wait for a new run or stop
+    std::condition_variable m_done;  // run() waits for the workers to finish
+    uint64_t m_generation;           // Incremented for each run() the workers take part in
+    unsigned m_pending;              // Workers still busy with the current run
+    bool m_stopping;
+};
+
+}  // namespace VirtualDesktop
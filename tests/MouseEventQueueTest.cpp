@@ -0,0 +1,181 @@
+// A trigger press must always reach the worker with its release, whatever else the full queue refuses
+#include "MouseEventQueue.h"
+#include "TestHarness.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+namespace VirtualDesktop {
+namespace {
+
+using Item = MouseEventQueue::Item;
+
+// Event kinds as MouseHook tags them; the queue only passes them on
+constexpr uint32_t TRIGGER = 1;
+constexpr uint32_t MOVE = 4;
+
+// Messages distinguishing presses from releases; x numbers the events in the order they were pushed
+constexpr uint32_t PRESS = 1;
+constexpr uint32_t RELEASE = 2;
+
+Item makeItem(uint32_t message, uint32_t kind, int32_t sequence) {
+    return {{message, sequence, 0, 0, 0}, kind};
+}
+
+// Pushes moves until the queue refuses one; returns how many it took
+int32_t fillWithMoves(MouseEventQueue& queue, int32_t& sequence) {
+    int32_t pushed = 0;
+    while (queue.pushEvent(makeItem(0, MOVE, sequence))) {
+        sequence++;
+        pushed++;
+    }
+    return pushed;
+}
+
+void testHeadroom() {
+    MouseEventQueue queue;
+    int32_t sequence = 0;
+    CHECK(static_cast<size_t>(fillWithMoves(queue, sequence)) ==
+          MouseEventQueue::CAPACITY - MouseEventQueue::TRIGGER_HEADROOM);
+    CHECK(queue.takeDroppedEvents() == 1);
+
+    // Moves are refused, but clicks still fit
+    CHECK(queue.pushPress(makeItem(PRESS, TRIGGER, sequence++)));
+    CHECK(queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence++)));
+    CHECK(!queue.pushEvent(makeItem(0, MOVE, sequence)));
+
+    Item item{};
+    int32_t expected = 0;
+    while (queue.tryPop(item)) {
+        CHECK(item.event.x == expected++);
+    }
+    CHECK(expected == sequence);
+    CHECK(item.event.message == RELEASE);
+}
+
+void testDroppedClick() {
+    MouseEventQueue queue;
+    int32_t sequence = 0;
+    fillWithMoves(queue, sequence);
+    while (queue.pushPress(makeItem(PRESS, TRIGGER, sequence))) {
+        sequence++;
+        CHECK(queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence++)));
+    }
+    queue.takeDroppedEvents();
+
+    // The press that did not fit is dropped with its release; the next click is queued once there is room
+    CHECK(!queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence)));
+    CHECK(queue.takeDroppedEvents() == 1);
+    Item item{};
+    CHECK(queue.tryPop(item) && item.event.x == 0);
+    CHECK(queue.pushPress(makeItem(PRESS, TRIGGER, sequence++)));
+    CHECK(!queue.pushPress(makeItem(PRESS, TRIGGER, sequence)));
+    CHECK(!queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence)));
+}
+
+void testPendingRelease() {
+    MouseEventQueue queue;
+    int32_t sequence = 0;
+    fillWithMoves(queue, sequence);
+    for (size_t i = 0; i + 2 < MouseEventQueue::TRIGGER_HEADROOM; i += 2) {
+        CHECK(queue.pushPress(makeItem(PRESS, TRIGGER, sequence++)));
+        CHECK(queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence++)));
+    }
+
+    // The worker took one event meanwhile, so the last press takes the last slot and its release does not fit
+    Item item{};
+    CHECK(queue.tryPop(item) && item.event.x == 0);
+    CHECK(queue.pushPress(makeItem(PRESS, TRIGGER, sequence++)));
+    CHECK(queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence++)));
+    CHECK(queue.pushPress(makeItem(PRESS, TRIGGER, sequence++)));
+    const int32_t release = sequence++;
+    CHECK(queue.pushRelease(makeItem(RELEASE, TRIGGER, release)));
+    CHECK(queue.takeDroppedEvents() == 1);  // Only the move refused while filling
+
+    // Nothing may overtake the set-aside release
+    CHECK(!queue.pushEvent(makeItem(0, MOVE, sequence)));
+    CHECK(!queue.pushPress(makeItem(PRESS, TRIGGER, sequence)));
+    CHECK(!queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence)));
+    CHECK(queue.takeDroppedEvents() == 3);
+
+    int32_t expected = 1;
+    while (queue.tryPop(item)) {
+        CHECK(item.event.x == expected++);
+    }
+    CHECK(expected == release + 1);
+    CHECK(item.event.message == RELEASE);
+    CHECK(queue.empty());
+
+    // Once the release is delivered, events are queued again
+    CHECK(queue.pushEvent(makeItem(0, MOVE, sequence)));
+    CHECK(queue.tryPop(item) && item.event.x == sequence);
+}
+
+void testTwoThreads() {
+    // The worker stalls now and then, so the hook keeps running into the full queue mid-click
+    constexpr int32_t CLICKS = 20000;
+    constexpr int32_t MOVES_PER_CLICK = 100;
+    MouseEventQueue queue;
+    std::atomic<bool> done{false};
+    int32_t clicks = 0;
+    std::thread producer([&] {
+        int32_t sequence = 0;
+        for (int32_t click = 0; click < CLICKS; ++click) {
+            if (queue.pushPress(makeItem(PRESS, TRIGGER, sequence++))) {
+                clicks++;
+            }
+            for (int32_t i = 0; i < MOVES_PER_CLICK; ++i) {
+                queue.pushEvent(makeItem(0, MOVE, sequence++));
+            }
+            queue.pushRelease(makeItem(RELEASE, TRIGGER, sequence++));
+        }
+        done.store(true);
+    });
+
+    bool pressed = false;
+    bool paired = true;
+    bool ordered = true;
+    int32_t last = -1;
+    int32_t releases = 0;
+    int32_t popped = 0;
+    Item item{};
+    for (;;) {
+        const bool finished = done.load();
+        if (!queue.tryPop(item)) {
+            if (finished) {
+                break;
+            }
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && item.event.x > last;
+        last = item.event.x;
+        if (item.kind == TRIGGER) {
+            paired = paired && pressed == (item.event.message == RELEASE);
+            pressed = item.event.message == PRESS;
+            releases += item.event.message == RELEASE ? 1 : 0;
+        }
+        if (++popped % 4096 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(paired);
+    CHECK(!pressed);
+    CHECK(releases == clicks);
+    CHECK(clicks > 0);
+    CHECK(queue.takeDroppedEvents() > 0);  // The full queue was actually hit
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main() {
+    VirtualDesktop::testHeadroom();
+    VirtualDesktop::testDroppedClick();
+    VirtualDesktop::testPendingRelease();
+    VirtualDesktop::testTwoThreads();
+    return VirtualDesktop::Test::finish();
+}
@@ -0,0 +1,115 @@
+// Recognizing a gesture must not touch the heap: it runs on the mouse hook's worker on every button release
+#include "GestureAnalyzer.h"
+#include "IGestureRecognizer.h"
+#include "TestHarness.h"
+#include "UnistrokeRecognizer.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+std::atomic<uint64_t> g_allocations{0};  // Heap allocations made anywhere in the process
+}  // namespace
+
+// Count every allocation; the recognizers are compiled into this executable, so theirs are included
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* block = std::malloc(size ? size : 1)) {
+        return block;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block) noexcept {
+    std::free(block);
+}
+
+void operator delete(void* block, size_t) noexcept {
+    std::free(block);
+}
+
+void operator delete[](void* block, size_t) noexcept {
+    std::free(block);
+}
+
+namespace VirtualDesktop {
+namespace {
+
+using Positions = IGestureRecognizer::Positions;
+
+// A swipe to the right with a wobble and a loop, so every engine has real work to do
+Positions makeStroke() {
+    Positions stroke;
+    for (int i = 0; i < 200; ++i) {
+        double t = i / 199.0;
+        stroke.push_back(
+                {static_cast<int32_t>(400.0 * t + 40.0 * std::cos(t * 9.0)),
+                 static_cast<int32_t>(30.0 * std::sin(t * 9.0))});
+    }
+    return stroke;
+}
+
+// Allocations made by a call, including the first one, which must not set anything up lazily either
+template <typename Call>
+uint64_t allocationsOf(Call call) {
+    uint64_t before = g_allocations.load();
+    call();
+    call();
+    return g_allocations.load() - before;
+}
+
+void testUnistrokeRecognizer(const Positions& stroke) {
+    for (auto matcher : {UnistrokeRecognizer::Matcher::GoldenSection, UnistrokeRecognizer::Matcher::Protractor}) {
+        for (bool streaming : {false, true}) {
+            UnistrokeRecognizer recognizer(matcher);
+            recognizer.setStreaming(streaming);
+            for (const auto& position : stroke) {
+                recognizer.addPoint(position.first, position.second);
+            }
+            uint64_t allocations = allocationsOf([&] {
+                recognizer.recognize(stroke);
+            });
+            CHECK(allocations == 0);
+        }
+    }
+}
+
+void testEngines(const Positions& stroke) {
+    for (const std::string& name : recognizerNames()) {
+        GestureAnalyzer analyzer;
+        CHECK(analyzer.setRecognizer(name));
+        uint32_t time = 0;
+        for (const auto& position : stroke) {
+            analyzer.addPosition(position.first, position.second, time += 8);
+        }
+        uint64_t allocations = allocationsOf([&] {
+            analyzer.analyzeGesture();
+            analyzer.analyzeEarly(0.9, 200.0);
+        });
+        if (!CHECK(allocations == 0)) {
+            fprintf(stderr, "  engine %s allocated %llu times\n", name.c_str(), (unsigned long long)allocations);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main() {
+    const VirtualDesktop::Positions stroke = VirtualDesktop::makeStroke();
+    VirtualDesktop::testUnistrokeRecognizer(stroke);
+    VirtualDesktop::testEngines(stroke);
+    return VirtualDesktop::Test::finish();
+}
@@ -0,0 +1,112 @@
+// The hook thread hands every mouse event to the worker through SpscQueue, so it must neither lose,
+// duplicate nor reorder items, at the ends of the ring or under contention
+#include "SpscQueue.h"
+#include "TestHarness.h"
+#include <cstdint>
+#include <thread>
+
+namespace VirtualDesktop {
+namespace {
+
+void testEmptyAndFull() {
+    SpscQueue<uint32_t, 8> queue;
+    uint32_t item = 0;
+    CHECK(queue.empty());
+    CHECK(!queue.tryPop(item));
+
+    for (uint32_t i = 0; i < 8; ++i) {
+        CHECK(queue.push(i));
+    }
+    CHECK(!queue.empty());
+    CHECK(!queue.push(8));  // Full: the item is refused and the queued ones are kept
+
+    CHECK(queue.tryPop(item) && item == 0);
+    CHECK(queue.push(8));  // One slot was freed
+    CHECK(!queue.push(9));
+    for (uint32_t i = 1; i <= 8; ++i) {
+        CHECK(queue.tryPop(item) && item == i);
+    }
+    CHECK(queue.empty());
+    CHECK(!queue.tryPop(item));
+}
+
+void testWraparound() {
+    // Indices run far past the capacity, so every slot is reused many times at every fill level
+    SpscQueue<uint32_t, 4> queue;
+    uint32_t next = 0;
+    uint32_t expected = 0;
+    for (int round = 0; round < 1000; ++round) {
+        const int fill = round % 5;
+        for (int i = 0; i < fill; ++i) {
+            CHECK(queue.push(next++));
+        }
+        uint32_t item = 0;
+        while (queue.tryPop(item)) {
+            if (!CHECK(item == expected)) {
+                return;
+            }
+            expected++;
+        }
+    }
+    CHECK(expected == next);
+}
+
+void testHeadroom() {
+    SpscQueue<uint32_t, 8> queue;
+    for (uint32_t i = 0; i < 6; ++i) {
+        CHECK(queue.push(i, 2));
+    }
+    CHECK(!queue.push(6, 2));  // Only the two reserved slots are left
+    CHECK(queue.push(6));
+    CHECK(queue.push(7));
+    CHECK(!queue.push(8));
+
+    uint32_t item = 0;
+    CHECK(queue.tryPop(item) && item == 0);
+    CHECK(!queue.push(8, 2));
+    CHECK(queue.push(8, 0));
+    for (uint32_t i = 1; i <= 8; ++i) {
+        CHECK(queue.tryPop(item) && item == i);
+    }
+    CHECK(queue.push(9, 7));  // An empty queue takes an item with all but one slot reserved
+    CHECK(!queue.push(10, 7));
+}
+
+void testTwoThreads() {
+    // A small ring keeps both threads hitting the full and empty cases
+    constexpr uint64_t COUNT = 1000000;
+    SpscQueue<uint64_t, 64> queue;
+    std::thread producer([&queue] {
+        for (uint64_t i = 0; i < COUNT; ++i) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    uint64_t expected = 0;
+    bool ordered = true;
+    while (expected < COUNT) {
+        uint64_t item = 0;
+        if (!queue.tryPop(item)) {
+            std::this_thread::yield();
+            continue;
+        }
+        ordered = ordered && item == expected;
+        expected++;
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(queue.empty());
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main() {
+    VirtualDesktop::testEmptyAndFull();
+    VirtualDesktop::testWraparound();
+    VirtualDesktop::testHeadroom();
+    VirtualDesktop::testTwoThreads();
+    return VirtualDesktop::Test::finish();
+}
@@ -0,0 +1,185 @@
+// Resampling a stroke while it is drawn must give the candidate that resampling it on release gives
+#include "IGestureRecognizer.h"
+#include "TestHarness.h"
+#include "UnistrokeRecognizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace VirtualDesktop {
+namespace {
+
+using Positions = IGestureRecognizer::Positions;
+using Direction = IGestureRecognizer::Direction;
+
+// Largest distance between corresponding candidate points, in the 250-unit box the candidates are scaled to
+constexpr double MAX_POINT_ERROR = 1.5;
+// Largest difference of the golden-section distance to the closest template
+constexpr double MAX_DISTANCE_ERROR = 0.25;
+
+// Exposes the prepared candidate
+class Probe : public UnistrokeRecognizer {
+public:
+    using UnistrokeRecognizer::candidate;
+    using UnistrokeRecognizer::prepareCandidate;
+};
+
+struct Stroke {
+    std::string name;
+    Positions points;
+};
+
+// Samples f(t) for t in [0, 1] at the given number of positions, rounded to pixels like mouse input
+template <typename Shape>
+Stroke makeStroke(const std::string& name, int count, Shape shape) {
+    Stroke stroke = {name, {}};
+    for (int i = 0; i < count; ++i) {
+        double t = static_cast<double>(i) / (count - 1);
+        double x = 0.0;
+        double y = 0.0;
+        shape(t, x, y);
+        stroke.points.push_back({static_cast<int32_t>(std::lround(x)), static_cast<int32_t>(std::lround(y))});
+    }
+    return stroke;
+}
+
+// Short and long strokes of every direction; the long ones decimate the stream several times
+std::vector<Stroke> makeStrokes() {
+    std::vector<Stroke> strokes;
+    for (double length : {120.0, 600.0, 3000.0}) {
+        const int count = static_cast<int>(length / 4.0);
+        const std::string size = std::to_string(static_cast<int>(length));
+        strokes.push_back(makeStroke("right " + size, count, [&](double t, double& x, double& y) {
+            x = length * t;
+            y = 0.05 * length * std::sin(t * 7.0);
+        }));
+        strokes.push_back(makeStroke("left " + size, count, [&](double t, double& x, double& y) {
+            x = -length * t;
+            y = 0.08 * length * t * t;
+        }));
+        strokes.push_back(makeStroke("down " + size, count, [&](double t, double& x, double& y) {
+            x = 0.1 * length * std::sin(t * 3.0);
+            y = length * t;
+        }));
+        strokes.push_back(makeStroke("up " + size, count, [&](double t, double& x, double& y) {
+            x = 0.03 * length * std::cos(t * 11.0);
+            y = -length * t;
+        }));
+        strokes.push_back(makeStroke("circle " + size, count, [&](double t, double& x, double& y) {
+            x = 0.5 * length * std::cos(t * 6.2);
+            y = 0.5 * length * std::sin(t * 6.2);
+        }));
+        strokes.push_back(makeStroke("zigzag " + size, count, [&](double t, double& x, double& y) {
+            x = length * t;
+            y = 0.2 * length * std::abs(std::fmod(t * 6.0, 2.0) - 1.0);
+        }));
+    }
+    // Fast mouse: few positions far apart, and a stroke that stops with repeated positions
+    strokes.push_back(makeStroke("sparse", 6, [](double t, double& x, double& y) {
+        x = 500.0 * t;
+        y = 40.0 * t * t;
+    }));
+    strokes.push_back(makeStroke("pause", 120, [](double t, double& x, double& y) {
+        x = 300.0 * std::min(t, 0.5);
+        y = 20.0 * std::min(t, 0.5);
+    }));
+    return strokes;
+}
+
+void feed(UnistrokeRecognizer& recognizer, const Positions& points) {
+    recognizer.reset();
+    for (const auto& position : points) {
+        recognizer.addPoint(position.first, position.second);
+    }
+}
+
+void testCandidates(const std::vector<Stroke>& strokes) {
+    Probe batch;
+    Probe streamed;
+    streamed.setStreaming(true);
+    for (const Stroke& stroke : strokes) {
+        feed(batch, stroke.points);
+        feed(streamed, stroke.points);
+        CHECK(batch.prepareCandidate(stroke.points));
+        GesturePath expected = batch.candidate();
+        CHECK(streamed.prepareCandidate(stroke.points));
+        const GesturePath& actual = streamed.candidate();
+
+        double error = 0.0;
+        for (size_t i = 0; i < expected.size(); ++i) {
+            error = std::max(error, std::hypot(actual.x[i] - expected.x[i], actual.y[i] - expected.y[i]));
+        }
+        if (!CHECK(actual.size() == expected.size() && error <= MAX_POINT_ERROR)) {
+            fprintf(stderr, "  stroke %s: candidate points differ by %.3f\n", stroke.name.c_str(), error);
+        }
+    }
+}
+
+void testDecisions(const std::vector<Stroke>& strokes) {
+    for (auto matcher : {UnistrokeRecognizer::Matcher::GoldenSection, UnistrokeRecognizer::Matcher::Protractor}) {
+        UnistrokeRecognizer batch(matcher);
+        UnistrokeRecognizer streamed(matcher);
+        streamed.setStreaming(true);
+        for (const Stroke& stroke : strokes) {
+            feed(batch, stroke.points);
+            feed(streamed, stroke.points);
+            Direction expected = Direction::None;
+            Direction actual = Direction::None;
+            double expectedDistance = batch.closestTemplate(stroke.points, expected);
+            double actualDistance = streamed.closestTemplate(stroke.points, actual);
+            CHECK(actual == expected);
+            CHECK(streamed.recognize(stroke.points) == batch.recognize(stroke.points));
+            if (matcher == UnistrokeRecognizer::Matcher::GoldenSection &&
+                !CHECK(std::abs(actualDistance - expectedDistance) <= MAX_DISTANCE_ERROR)) {
+                fprintf(stderr,
+                        "  stroke %s: distance %.3f streamed, %.3f in batch\n",
+                        stroke.name.c_str(),
+                        actualDistance,
+                        expectedDistance);
+            }
+        }
+    }
+}
+
+// The registered engine streams, and a stroke in progress when streaming is enabled falls back to batch
+void testEngine(const std::vector<Stroke>& strokes) {
+    std::unique_ptr<IGestureRecognizer> engine = createRecognizer("unistroke_streaming");
+    std::unique_ptr<IGestureRecognizer> reference = createRecognizer("unistroke");
+    CHECK(engine && reference);
+    if (!engine || !reference) {
+        return;
+    }
+    for (const Stroke& stroke : strokes) {
+        engine->reset();
+        reference->reset();
+        for (const auto& position : stroke.points) {
+            engine->addPoint(position.first, position.second);
+            reference->addPoint(position.first, position.second);
+        }
+        CHECK(engine->recognize(stroke.points) == reference->recognize(stroke.points));
+    }
+
+    UnistrokeRecognizer late;
+    const Stroke& stroke = strokes.front();
+    feed(late, Positions(stroke.points.begin(), stroke.points.begin() + stroke.points.size() / 2));
+    late.setStreaming(true);
+    for (size_t i = stroke.points.size() / 2; i < stroke.points.size(); ++i) {
+        late.addPoint(stroke.points[i].first, stroke.points[i].second);
+    }
+    UnistrokeRecognizer batch;
+    CHECK(late.recognize(stroke.points) == batch.recognize(stroke.points));
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main() {
+    const std::vector<VirtualDesktop::Stroke> strokes = VirtualDesktop::makeStrokes();
+    VirtualDesktop::testCandidates(strokes);
+    VirtualDesktop::testDecisions(strokes);
+    VirtualDesktop::testEngine(strokes);
+    return VirtualDesktop::Test::finish();
+}
@@ -0,0 +1,366 @@
+// StrokeRasterizer must cover each pixel by its distance to the stroke, at the edges and round caps too, and
+// write valid premultiplied BGRA. Golden images pin what it draws, and TrailCanvas must produce exactly those
+// pixels however it splits a trail into tiles, frames and threads.
+#include "StrokeRasterizer.h"
+#include "TestHarness.h"
+#include "TrailCanvas.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace VirtualDesktop {
+namespace {
+
+// Largest alpha difference from the analytic coverage, for pixel centres where float and double round apart
+constexpr int MAX_COVERAGE_ERROR = 1;
+
+struct Segment {
+    float ax, ay, bx, by;
+};
+
+// Distance from (x, y) to segment a-b
+double distanceToSegment(const Segment& segment, double x, double y) {
+    const double dx = segment.bx - segment.ax;
+    const double dy = segment.by - segment.ay;
+    const double length2 = dx * dx + dy * dy;
+    const double px = x - segment.ax;
+    const double py = y - segment.ay;
+    const double t = length2 > 0.0 ? std::clamp((px * dx + py * dy) / length2, 0.0, 1.0) : 0.0;
+    return std::hypot(px - t * dx, py - t * dy);
+}
+
+// Alpha of a pixel at the given distance from the segment: full inside the capsule, falling linearly to 0
+// across the one-pixel band around its edge
+int expectedAlpha(double distance, float width, uint8_t alpha) {
+    const double coverage = std::clamp(width / 2.0 + 0.5 - distance, 0.0, 1.0);
+    const long covered = std::lround(coverage * 255.0);
+    return static_cast<int>(std::lround(covered * alpha / 255.0));
+}
+
+void testCoverage() {
+    constexpr int WIDTH = 80;
+    constexpr int HEIGHT = 60;
+    // Horizontal, vertical, diagonal, steep, a dot, and segments ending off the surface
+    const Segment segments[] = {
+            {20.0f, 30.0f, 60.0f, 30.0f},
+            {40.0f, 10.0f, 40.0f, 50.0f},
+            {15.0f, 12.0f, 65.0f, 48.0f},
+            {37.0f, 5.0f, 43.0f, 55.0f},
+            {40.0f, 30.0f, 40.0f, 30.0f},
+            {-10.0f, 20.0f, 90.0f, 40.0f},
+    };
+    StrokeRasterizer rasterizer;
+    for (float width : {1.0f, 2.5f, 5.0f, 12.0f}) {
+        rasterizer.setStyle(0xFFFFFF, 0xFF, width);
+        for (const Segment& segment : segments) {
+            std::vector<uint32_t> pixels(WIDTH * HEIGHT, 0);
+            rasterizer.drawSegment(
+                    pixels.data(),
+                    WIDTH,
+                    0,
+                    0,
+                    WIDTH,
+                    HEIGHT,
+                    segment.ax,
+                    segment.ay,
+                    segment.bx,
+                    segment.by);
+
+            int error = 0;
+            for (int y = 0; y < HEIGHT; ++y) {
+                for (int x = 0; x < WIDTH; ++x) {
+                    const int alpha = static_cast<int>(pixels[y * WIDTH + x] >> 24);
+                    const int expected = expectedAlpha(distanceToSegment(segment, x, y), width, 0xFF);
+                    error = std::max(error, std::abs(alpha - expected));
+                }
+            }
+            if (!CHECK(error <= MAX_COVERAGE_ERROR)) {
+                fprintf(stderr,
+                        "  width %.1f, segment (%.0f, %.0f)-(%.0f, %.0f): alpha differs by up to %d\n",
+                        width,
+                        segment.ax,
+                        segment.ay,
+                        segment.bx,
+                        segment.by,
+                        error);
+            }
+        }
+    }
+
+    // The caps of a width-8 segment: solid up to 3.5 pixels past the end, half covered at 4, clear from 4.5 on
+    rasterizer.setStyle(0xFFFFFF, 0xFF, 8.0f);
+    std::vector<uint32_t> pixels(WIDTH * HEIGHT, 0);
+    rasterizer.drawSegment(pixels.data(), WIDTH, 0, 0, WIDTH, HEIGHT, 20.0f, 30.0f, 60.0f, 30.0f);
+    auto alphaAt = [&pixels](int x, int y) {
+        return pixels[y * WIDTH + x] >> 24;
+    };
+    CHECK(alphaAt(63, 30) == 0xFF && alphaAt(17, 30) == 0xFF);
+    CHECK(alphaAt(64, 30) >= 0x7F && alphaAt(64, 30) <= 0x80);
+    CHECK(alphaAt(16, 30) >= 0x7F && alphaAt(16, 30) <= 0x80);
+    CHECK(alphaAt(65, 30) == 0 && alphaAt(15, 30) == 0);
+    // The edges the same way, across the segment
+    CHECK(alphaAt(40, 33) == 0xFF && alphaAt(40, 27) == 0xFF);
+    CHECK(alphaAt(40, 34) >= 0x7F && alphaAt(40, 34) <= 0x80);
+    CHECK(alphaAt(40, 35) == 0 && alphaAt(40, 25) == 0);
+    // The corner of the cap is round, not square
+    CHECK(alphaAt(63, 33) < 0xFF && alphaAt(64, 34) == 0);
+}
+
+void testPremultiplied() {
+    constexpr int WIDTH = 40;
+    constexpr int HEIGHT = 24;
+    // Black and near-black trails included: they must be drawn with full alpha
+    const uint32_t colors[] = {0x000000, 0x010101, 0x0A0A0A, 0xFFFFFF, 0x6495ED, 0xFF0080, 0x12FE34};
+    const uint8_t alphas[] = {0x00, 0x01, 0x80, 0xAA, 0xFF};
+    StrokeRasterizer rasterizer;
+    for (uint32_t color : colors) {
+        for (uint8_t alpha : alphas) {
+            rasterizer.setStyle(color, alpha, 6.0f);
+            std::vector<uint32_t> pixels(WIDTH * HEIGHT, 0);
+            rasterizer.drawSegment(pixels.data(), WIDTH, 0, 0, WIDTH, HEIGHT, 5.0f, 4.0f, 33.0f, 19.0f);
+
+            bool valid = true;
+            uint32_t maxAlpha = 0;
+            for (uint32_t pixel : pixels) {
+                // Each channel is the stroke colour's channel scaled by the pixel's alpha, rounded to nearest
+                const uint32_t a = pixel >> 24;
+                for (int shift : {16, 8, 0}) {
+                    const uint32_t expected = static_cast<uint32_t>(std::lround(((color >> shift) & 0xFF) * a / 255.0));
+                    valid = valid && ((pixel >> shift) & 0xFF) == expected;
+                }
+                maxAlpha = std::max(maxAlpha, a);
+            }
+            if (!CHECK(valid && maxAlpha == alpha)) {
+                fprintf(stderr, "  color %06X, alpha %u: invalid pixels or peak alpha %u\n", color, alpha, maxAlpha);
+            }
+        }
+    }
+}
+
+// Drawing into a rectangle of a larger surface clips to it and matches the same pixels of a full draw
+void testRectangle() {
+    constexpr int WIDTH = 80;
+    constexpr int HEIGHT = 60;
+    constexpr int LEFT = 23;
+    constexpr int TOP = 17;
+    constexpr int RECT_WIDTH = 30;
+    constexpr int RECT_HEIGHT = 20;
+    StrokeRasterizer rasterizer;
+    rasterizer.setStyle(0x6495ED, 0xAA, 9.0f);
+    const Segment segments[] = {
+            {10.0f, 10.0f, 70.0f, 50.0f},   // Crosses the rectangle
+            {20.0f, 20.0f, 21.0f, 45.0f},   // Only its edge reaches in from the left
+            {60.0f, 30.0f, 60.0f, 30.0f},   // A dot just right of it
+            {40.0f, -30.0f, 40.0f, -5.0f},  // Far above the surface
+    };
+    for (const Segment& segment : segments) {
+        std::vector<uint32_t> full(WIDTH * HEIGHT, 0);
+        rasterizer.drawSegment(full.data(), WIDTH, 0, 0, WIDTH, HEIGHT, segment.ax, segment.ay, segment.bx, segment.by);
+
+        // The rectangle in a buffer of its own, so a write outside it lands past the end or in the margin
+        constexpr int STRIDE = RECT_WIDTH + 4;
+        std::vector<uint32_t> rect(STRIDE * RECT_HEIGHT, 0);
+        rasterizer.drawSegment(
+                rect.data(),
+                STRIDE,
+                LEFT,
+                TOP,
+                RECT_WIDTH,
+                RECT_HEIGHT,
+                segment.ax,
+                segment.ay,
+                segment.bx,
+                segment.by);
+
+        bool same = true;
+        for (int y = 0; y < RECT_HEIGHT; ++y) {
+            for (int x = 0; x < STRIDE; ++x) {
+                const uint32_t expected = x < RECT_WIDTH ? full[(TOP + y) * WIDTH + LEFT + x] : 0;
+                same = same && rect[y * STRIDE + x] == expected;
+            }
+        }
+        CHECK(same);
+    }
+}
+
+constexpr int GOLDEN_WIDTH = 16;
+constexpr int GOLDEN_HEIGHT = 10;
+// Largest alpha difference from a golden image, for compilers rounding the coverage arithmetic differently
+constexpr int MAX_GOLDEN_ERROR = 1;
+
+struct Golden {
+    const char* name;
+    float width;
+    float ax, ay, bx, by;
+    const char* rows[GOLDEN_HEIGHT];  // Alpha of each pixel in hex, opaque white stroke
+};
+
+const Golden GOLDEN_IMAGES[] = {
+        {"horizontal", 5.0f, 3.0f, 4.0f, 12.0f, 4.0f, {
+                "00000000000000000000000000000000",
+                "00000000000000000000000000000000",
+                "002cc3ffffffffffffffffffffc32c00",
+                "00c3ffffffffffffffffffffffffc300",
+                "00ffffffffffffffffffffffffffff00",
+                "00c3ffffffffffffffffffffffffc300",
+                "002cc3ffffffffffffffffffffc32c00",
+                "00000000000000000000000000000000",
+                "00000000000000000000000000000000",
+                "00000000000000000000000000000000",
+        }},
+        {"diagonal", 3.0f, 2.0f, 1.0f, 13.0f, 8.0f, {
+                "0095ff9e150000000000000000000000",
+                "00ffffffec6300000000000000000000",
+                "0095ffffffffb2290000000000000000",
+                "000050d9ffffffff7700000000000000",
+                "000000028affffffffc53c0000000000",
+                "00000000003cc5ffffffff8a02000000",
+                "0000000000000077ffffffffd9500000",
+                "000000000000000029b2ffffffff9500",
+                "0000000000000000000063ecffffff00",
+                "0000000000000000000000159eff9500",
+        }},
+        {"dot", 6.0f, 8.0f, 5.0f, 8.0f, 5.0f, {
+                "00000000000000000000000000000000",
+                "00000000000000000000000000000000",
+                "00000000000000568056000000000000",
+                "000000000000abffffffab0000000000",
+                "000000000056ffffffffff5600000000",
+                "000000000080ffffffffff8000000000",
+                "000000000056ffffffffff5600000000",
+                "000000000000abffffffab0000000000",
+                "00000000000000568056000000000000",
+                "00000000000000000000000000000000",
+        }},
+};
+
+int goldenAlpha(const Golden& golden, int x, int y) {
+    const char digits[3] = {golden.rows[y][2 * x], golden.rows[y][2 * x + 1], 0};
+    return static_cast<int>(strtol(digits, nullptr, 16));
+}
+
+void testGoldenImages() {
+    StrokeRasterizer rasterizer;
+    for (const Golden& golden : GOLDEN_IMAGES) {
+        rasterizer.setStyle(0xFFFFFF, 0xFF, golden.width);
+        std::vector<uint32_t> pixels(GOLDEN_WIDTH * GOLDEN_HEIGHT, 0);
+        rasterizer.drawSegment(
+                pixels.data(),
+                GOLDEN_WIDTH,
+                0,
+                0,
+                GOLDEN_WIDTH,
+                GOLDEN_HEIGHT,
+                golden.ax,
+                golden.ay,
+                golden.bx,
+                golden.by);
+
+        int error = 0;
+        for (int y = 0; y < GOLDEN_HEIGHT; ++y) {
+            for (int x = 0; x < GOLDEN_WIDTH; ++x) {
+                const int alpha = static_cast<int>(pixels[y * GOLDEN_WIDTH + x] >> 24);
+                error = std::max(error, std::abs(alpha - goldenAlpha(golden, x, y)));
+            }
+        }
+        if (!CHECK(error <= MAX_GOLDEN_ERROR)) {
+            fprintf(stderr, "  image %s: alpha differs by up to %d\n", golden.name, error);
+        }
+    }
+}
+
+// Random trails across several tiles, with long jumps, back-tracking and repeated points
+std::vector<TrailCanvas::Point> makeTrail(std::mt19937& random, int width, int height, size_t count) {
+    std::uniform_int_distribution<int32_t> step(-40, 40);
+    std::uniform_int_distribution<int32_t> jump(0, 9);
+    std::vector<TrailCanvas::Point> points = {{width / 2, height / 2}};
+    while (points.size() < count) {
+        TrailCanvas::Point point = points.back();
+        if (jump(random) == 0) {
+            point = {std::uniform_int_distribution<int32_t>(-20, width + 20)(random),
+                     std::uniform_int_distribution<int32_t>(-20, height + 20)(random)};
+        } else if (jump(random) != 1) {
+            point = {point.x + step(random), point.y + step(random)};
+        }
+        points.push_back(point);
+    }
+    return points;
+}
+
+// The whole trail drawn straight into one surface-sized image
+std::vector<uint32_t> rasterize(const std::vector<TrailCanvas::Point>& points, int width, int height) {
+    StrokeRasterizer rasterizer;
+    rasterizer.setStyle(0x10E0A0, 0xC0, 7.0f);
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height, 0);
+    for (size_t i = 0; i + 1 < points.size(); ++i) {
+        rasterizer.drawSegment(
+                pixels.data(),
+                width,
+                0,
+                0,
+                width,
+                height,
+                static_cast<float>(points[i].x),
+                static_cast<float>(points[i].y),
+                static_cast<float>(points[i + 1].x),
+                static_cast<float>(points[i + 1].y));
+    }
+    return pixels;
+}
+
+// The canvas's tiles copied into one surface-sized image
+std::vector<uint32_t> compose(const TrailCanvas& canvas, int width, int height) {
+    const int size = TiledSurface::TILE_SIZE;
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height, 0);
+    for (const TiledSurface::Tile& tile : canvas.surface().tiles()) {
+        for (int y = 0; y < size && tile.ty * size + y < height; ++y) {
+            for (int x = 0; x < size && tile.tx * size + x < width; ++x) {
+                const size_t pixel = static_cast<size_t>(tile.ty * size + y) * width + tile.tx * size + x;
+                pixels[pixel] = tile.pixels[y * size + x];
+            }
+        }
+    }
+    return pixels;
+}
+
+void testCanvasMatchesRasterizer() {
+    constexpr int WIDTH = 500;
+    constexpr int HEIGHT = 300;
+    std::mt19937 random(7);
+    for (unsigned threads : {1u, 4u}) {
+        TrailCanvas canvas;
+        canvas.resize(WIDTH, HEIGHT);
+        canvas.setStyle(0x10E0A0, 0xC0, 7.0f);
+        canvas.setThreads(threads);
+        for (int trail = 0; trail < 20; ++trail) {
+            const std::vector<TrailCanvas::Point> points = makeTrail(random, WIDTH, HEIGHT, 60);
+            const std::vector<uint32_t> expected = rasterize(points, WIDTH, HEIGHT);
+
+            // One render of the whole trail, over whatever the previous trail left
+            canvas.render(points.data(), points.size());
+            CHECK(compose(canvas, WIDTH, HEIGHT) == expected);
+
+            // The same trail built up one point at a time
+            canvas.clear();
+            for (const TrailCanvas::Point& point : points) {
+                canvas.append(point);
+            }
+            CHECK(compose(canvas, WIDTH, HEIGHT) == expected);
+        }
+    }
+}
+
+}  // namespace
+}  // namespace VirtualDesktop
+
+int main() {
+    VirtualDesktop::testCoverage();
+    VirtualDesktop::testPremultiplied();
+    VirtualDesktop::testRectangle();
+    VirtualDesktop::testGoldenImages();
+    VirtualDesktop::testCanvasMatchesRasterizer();
+    return VirtualDesktop::Test::finish();
+}
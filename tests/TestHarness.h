@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdio>
+
+// Minimal checks for the standalone test executables. A failed check is reported and the test goes on;
+// main() returns finish(), which is the number of failed checks.
+namespace VirtualDesktop {
+namespace Test {
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline bool check(bool passed, const char* expression, const char* file, int line) {
+    if (!passed) {
+        fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        failures()++;
+    }
+    return passed;
+}
+
+inline int finish() {
+    if (failures() == 0) {
+        printf("All checks passed\n");
+    } else {
+        printf("%d checks failed\n", failures());
+    }
+    return failures();
+}
+
+}  // namespace Test
+}  // namespace VirtualDesktop
+
+#define CHECK(condition) ::VirtualDesktop::Test::check((condition), #condition, __FILE__, __LINE__)